@@ -0,0 +1,687 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sigslot.h"
+
+// Measures emit, connect/disconnect and teardown costs for every threading policy. Each line of
+// output is one CSV record:
+//
+//     benchmark,policy,args,slots,threads,ns_per_op,ops_per_sec
+//
+// where an op is one emit, one connect/disconnect pair or one object destroyed, as named by the
+// benchmark. Run with --quick for shorter runs, and with any other argument to run only the
+// benchmarks whose name or policy contains it.
+//
+// Receivers are allocated one at a time with unrelated allocations in between, the way
+// long-lived objects end up spread over the heap in a real program.
+
+static double g_min_time = 0.2;
+static const char* g_filter = NULL;
+
+static bool selected(const char* benchmark, const char* policy)
+{
+    return g_filter == NULL || strstr(benchmark, g_filter) != NULL || strstr(policy, g_filter) != NULL;
+}
+
+static void report(const char* benchmark, const char* policy, size_t args, size_t slots,
+    size_t threads, double ns)
+{
+    printf("%s,%s,%u,%u,%u,%.2f,%.0f\n", benchmark, policy, (unsigned)args, (unsigned)slots,
+        (unsigned)threads, ns, 1e9 / ns);
+    fflush(stdout);
+}
+
+// Calls run(n) with n doubling until one call takes at least g_min_time, and returns the time
+// per iteration of that call in nanoseconds.
+template<class run_type>
+double measure(run_type run)
+{
+    for(long iterations = 1; ; iterations *= 2)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        run(iterations);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+            start).count();
+
+        if(seconds >= g_min_time || iterations >= (1L << 40))
+            return seconds * 1e9 / iterations;
+    }
+}
+
+// Aborts the program unless destroyed within the given time, so that a deadlock in a stress run
+// fails with a message instead of hanging.
+class Watchdog
+{
+public:
+    Watchdog(const char* benchmark, const char* policy, double seconds)
+        : m_benchmark(benchmark), m_policy(policy), m_seconds(seconds), m_done(false),
+        m_thread(&Watchdog::watch, this)
+    {
+    }
+
+    ~Watchdog()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+private:
+    void watch()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if(!m_wake.wait_for(lock, std::chrono::duration<double>(m_seconds), [this] { return m_done; }))
+        {
+            fprintf(stderr, "%s,%s: no progress in %.0f s, deadlocked\n", m_benchmark, m_policy,
+                m_seconds);
+            abort();
+        }
+    }
+
+    const char* m_benchmark;
+    const char* m_policy;
+    double m_seconds;
+    bool m_done;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+};
+
+// Slots touch only the calling thread's counter, so that contended emits measure the signal
+// rather than the receivers.
+static long& counter()
+{
+    static thread_local long count = 0;
+    return count;
+}
+
+template<class mt_policy>
+class Receiver : public sigslot::has_slots<mt_policy>
+{
+public:
+    template<class... arg_types>
+    void OnValue(arg_types...)
+    {
+        ++counter();
+    }
+};
+
+template<class mt_policy, class... arg_types>
+class Subscribers
+{
+public:
+    typedef sigslot::basic_signal<mt_policy, arg_types...> signal_type;
+
+    Subscribers(signal_type& sig, size_t slots)
+    {
+        void (Receiver<mt_policy>::*slot)(arg_types...) =
+            &Receiver<mt_policy>::template OnValue<arg_types...>;
+
+        for(size_t i = 0; i < slots; ++i)
+        {
+            m_padding.push_back(new char[64 + rand() % 192]);
+            m_receivers.push_back(new Receiver<mt_policy>);
+            sig.connect(m_receivers.back(), slot);
+        }
+    }
+
+    ~Subscribers()
+    {
+        for(size_t i = 0; i < m_receivers.size(); ++i)
+        {
+            delete m_receivers[i];
+            delete[] m_padding[i];
+        }
+    }
+
+private:
+    std::vector<Receiver<mt_policy>*> m_receivers;
+    std::vector<char*> m_padding;
+};
+
+template<class mt_policy, class... arg_types>
+struct EmitBench
+{
+    static void run(const char* policy, arg_types... args)
+    {
+        static const size_t slot_counts[] = { 1, 10, 100, 1000, 10000 };
+
+        if(!selected("emit", policy))
+            return;
+
+        for(size_t i = 0; i < sizeof(slot_counts) / sizeof(slot_counts[0]); ++i)
+        {
+            sigslot::basic_signal<mt_policy, arg_types...> sig;
+            Subscribers<mt_policy, arg_types...> subscribers(sig, slot_counts[i]);
+
+            double ns = measure([&](long iterations)
+            {
+                for(long n = 0; n < iterations; ++n)
+                    sig.emit(args...);
+            });
+
+            report("emit", policy, sizeof...(arg_types), slot_counts[i], 1, ns);
+        }
+    }
+};
+
+template<class mt_policy>
+void bench_arities(const char* policy)
+{
+    EmitBench<mt_policy>::run(policy);
+    EmitBench<mt_policy, int>::run(policy, 1);
+    EmitBench<mt_policy, int, int>::run(policy, 1, 2);
+    EmitBench<mt_policy, int, int, int>::run(policy, 1, 2, 3);
+    EmitBench<mt_policy, int, int, int, int>::run(policy, 1, 2, 3, 4);
+    EmitBench<mt_policy, int, int, int, int, int>::run(policy, 1, 2, 3, 4, 5);
+    EmitBench<mt_policy, int, int, int, int, int, int>::run(policy, 1, 2, 3, 4, 5, 6);
+    EmitBench<mt_policy, int, int, int, int, int, int, int>::run(policy, 1, 2, 3, 4, 5, 6, 7);
+    EmitBench<mt_policy, int, int, int, int, int, int, int, int>::run(policy, 1, 2, 3, 4, 5, 6,
+        7, 8);
+}
+
+#ifndef _SIGSLOT_SINGLE_THREADED
+// Every thread emits the same signal; reports the wall time per emit across all threads.
+template<class mt_policy>
+void bench_contended(const char* policy)
+{
+    static const size_t slots = 8;
+
+    if(!selected("contended_emit", policy))
+        return;
+
+    size_t max_threads = std::thread::hardware_concurrency();
+
+    if(max_threads < 4)
+        max_threads = 4;
+
+    for(size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        sigslot::basic_signal<mt_policy, int> sig;
+        Subscribers<mt_policy, int> subscribers(sig, slots);
+
+        double ns = measure([&](long iterations)
+        {
+            long per_thread = (iterations + threads - 1) / threads;
+            std::vector<std::thread> workers;
+
+            for(size_t t = 0; t < threads; ++t)
+            {
+                workers.push_back(std::thread([&sig, per_thread]()
+                {
+                    for(long n = 0; n < per_thread; ++n)
+                        sig.emit(1);
+                }));
+            }
+
+            for(size_t t = 0; t < threads; ++t)
+                workers[t].join();
+        });
+
+        report("contended_emit", policy, 1, slots, threads, ns);
+    }
+}
+#endif
+
+// Each receiver wants the emits for one id. filtered_emit has every slot compare the id, and
+// keyed_emit connects each receiver under its id; ids are spread over the key space.
+template<class mt_policy>
+class IdReceiver : public sigslot::has_slots<mt_policy>
+{
+public:
+    IdReceiver(int id)
+        : m_id(id)
+    {
+    }
+
+    void OnAny(int id)
+    {
+        if(id != m_id)
+            return;
+
+        ++counter();
+    }
+
+    void OnMine(int)
+    {
+        ++counter();
+    }
+
+private:
+    int m_id;
+};
+
+template<class mt_policy>
+void bench_keyed(const char* policy)
+{
+    static const size_t slot_counts[] = { 10, 1000, 5000 };
+
+    if(!selected("filtered_emit", policy) && !selected("keyed_emit", policy))
+        return;
+
+    for(size_t i = 0; i < sizeof(slot_counts) / sizeof(slot_counts[0]); ++i)
+    {
+        sigslot::basic_signal<mt_policy, int> filtered;
+        sigslot::basic_keyed_signal<mt_policy, int> keyed;
+        std::vector<IdReceiver<mt_policy>*> receivers;
+
+        for(size_t r = 0; r < slot_counts[i]; ++r)
+        {
+            receivers.push_back(new IdReceiver<mt_policy>(int(r * 64)));
+            filtered.connect(receivers.back(), &IdReceiver<mt_policy>::OnAny);
+            keyed.connect(int(r * 64), receivers.back(), &IdReceiver<mt_policy>::OnMine);
+        }
+
+        if(selected("filtered_emit", policy))
+        {
+            double ns = measure([&](long iterations)
+            {
+                for(long n = 0; n < iterations; ++n)
+                    filtered.emit(int(n % slot_counts[i]) * 64);
+            });
+
+            report("filtered_emit", policy, 1, slot_counts[i], 1, ns);
+        }
+
+        if(selected("keyed_emit", policy))
+        {
+            double ns = measure([&](long iterations)
+            {
+                for(long n = 0; n < iterations; ++n)
+                    keyed.emit(int(n % slot_counts[i]) * 64);
+            });
+
+            report("keyed_emit", policy, 1, slot_counts[i], 1, ns);
+        }
+
+        for(size_t r = 0; r < receivers.size(); ++r)
+            delete receivers[r];
+    }
+}
+
+// Connects a receiver to a signal that already has some, then disconnects it again, the way
+// short-lived subscriptions come and go, once through the handle and once by receiver.
+template<class mt_policy>
+void bench_churn(const char* policy)
+{
+    static const size_t slot_counts[] = { 10, 1000 };
+
+    for(size_t i = 0; i < sizeof(slot_counts) / sizeof(slot_counts[0]); ++i)
+    {
+        sigslot::basic_signal<mt_policy, int> sig;
+        Subscribers<mt_policy, int> subscribers(sig, slot_counts[i]);
+        Receiver<mt_policy> receiver;
+
+        if(selected("churn_handle", policy))
+        {
+            double ns = measure([&](long iterations)
+            {
+                for(long n = 0; n < iterations; ++n)
+                    sig.connect(&receiver, &Receiver<mt_policy>::template OnValue<int>).disconnect();
+            });
+
+            report("churn_handle", policy, 1, slot_counts[i], 1, ns);
+        }
+
+        if(selected("churn_receiver", policy))
+        {
+            double ns = measure([&](long iterations)
+            {
+                for(long n = 0; n < iterations; ++n)
+                {
+                    sig.connect(&receiver, &Receiver<mt_policy>::template OnValue<int>);
+                    sig.disconnect(&receiver);
+                }
+            });
+
+            report("churn_receiver", policy, 1, slot_counts[i], 1, ns);
+        }
+    }
+}
+
+// Wires a signal to many receivers and disconnects them again, one call per receiver and then
+// with the bulk calls. Reports the time per connection.
+template<class mt_policy>
+void bench_bulk(const char* policy)
+{
+    static const size_t receivers = 1000;
+
+    if(!selected("bulk", policy) && !selected("connect_each", policy) &&
+        !selected("connect_many", policy) && !selected("disconnect_each", policy) &&
+        !selected("disconnect_all_of", policy))
+    {
+        return;
+    }
+
+    std::vector<Receiver<mt_policy>*> objects;
+
+    for(size_t r = 0; r < receivers; ++r)
+        objects.push_back(new Receiver<mt_policy>);
+
+    double ns[4] = { 0, 0, 0, 0 };
+    long rounds = 0;
+    double elapsed = 0;
+
+    while(elapsed < g_min_time || rounds < 3)
+    {
+        sigslot::basic_signal<mt_policy, int> sig;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+        for(size_t r = 0; r < receivers; ++r)
+            sig.connect(objects[r], &Receiver<mt_policy>::template OnValue<int>);
+
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+        for(size_t r = 0; r < receivers; ++r)
+            sig.disconnect(objects[r]);
+
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+        sig.connect_many(objects.begin(), objects.end(),
+            &Receiver<mt_policy>::template OnValue<int>);
+
+        std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+
+        sig.disconnect_all_of(objects.begin(), objects.end());
+
+        std::chrono::steady_clock::time_point t4 = std::chrono::steady_clock::now();
+
+        ns[0] += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        ns[1] += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        ns[2] += std::chrono::duration<double, std::nano>(t3 - t2).count();
+        ns[3] += std::chrono::duration<double, std::nano>(t4 - t3).count();
+        elapsed += std::chrono::duration<double>(t4 - t0).count();
+        ++rounds;
+    }
+
+    static const char* const names[] = { "connect_each", "disconnect_each", "connect_many",
+        "disconnect_all_of" };
+
+    for(size_t i = 0; i < 4; ++i)
+    {
+        if(selected("bulk", policy) || selected(names[i], policy))
+            report(names[i], policy, 1, receivers, 1, ns[i] / (rounds * receivers));
+    }
+
+    for(size_t r = 0; r < receivers; ++r)
+        delete objects[r];
+}
+
+// Destroys many receivers, each connected to several signals with many other receivers, and
+// then the signals themselves. Reports the time per object destroyed.
+template<class mt_policy>
+void bench_teardown(const char* policy)
+{
+    static const size_t receivers = 1000;
+    static const size_t signals = 8;
+
+    struct Signals
+    {
+        sigslot::basic_signal<mt_policy, int> sig[signals];
+    };
+
+    if(!selected("destroy_receivers", policy) && !selected("destroy_signals", policy))
+        return;
+
+    double receiver_ns = 0;
+    double signal_ns = 0;
+    long rounds = 0;
+    double elapsed = 0;
+
+    while(elapsed < g_min_time || rounds < 3)
+    {
+        Signals* sigs = new Signals;
+        std::vector<Receiver<mt_policy>*> objects;
+
+        for(size_t r = 0; r < receivers; ++r)
+        {
+            objects.push_back(new Receiver<mt_policy>);
+
+            for(size_t s = 0; s < signals; ++s)
+                sigs->sig[s].connect(objects.back(), &Receiver<mt_policy>::template OnValue<int>);
+        }
+
+        // Leave half the connections for the signals to tear down.
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for(size_t r = 0; r < receivers; r += 2)
+            delete objects[r];
+
+        std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+
+        delete sigs;
+
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+        for(size_t r = 1; r < receivers; r += 2)
+            delete objects[r];
+
+        receiver_ns += std::chrono::duration<double, std::nano>(middle - start).count();
+        signal_ns += std::chrono::duration<double, std::nano>(stop - middle).count();
+        elapsed += std::chrono::duration<double>(stop - start).count();
+        ++rounds;
+    }
+
+    if(selected("destroy_receivers", policy))
+        report("destroy_receivers", policy, 1, signals, 1, receiver_ns / (rounds * receivers / 2));
+
+    if(selected("destroy_signals", policy))
+        report("destroy_signals", policy, 1, receivers / 2, 1, signal_ns / (rounds * signals));
+}
+
+#ifndef _SIGSLOT_SINGLE_THREADED
+// Destroys a batch of signals on one thread while another destroys the receivers connected to
+// them, with every receiver connected to every signal, so that the two teardown paths meet on
+// every pair. It doubles as a stress test of the lock order: a policy that could deadlock here
+// eventually hangs. Reports the wall time per object destroyed.
+template<class mt_policy>
+void bench_teardown_race(const char* policy)
+{
+    static const size_t objects = 64;
+
+    if(!selected("teardown_race", policy))
+        return;
+
+    struct Signals
+    {
+        sigslot::basic_signal<mt_policy, int> sig[objects];
+    };
+
+    double ns = measure([&](long iterations)
+    {
+        for(long n = 0; n < iterations; n += objects * 2)
+        {
+            Signals* sigs = new Signals;
+            std::vector<Receiver<mt_policy>*> receivers;
+
+            for(size_t r = 0; r < objects; ++r)
+            {
+                receivers.push_back(new Receiver<mt_policy>);
+
+                for(size_t s = 0; s < objects; ++s)
+                    sigs->sig[s].connect(receivers[r], &Receiver<mt_policy>::template OnValue<int>);
+            }
+
+            std::thread destroyer([&receivers]()
+            {
+                for(size_t r = 0; r < receivers.size(); ++r)
+                    delete receivers[r];
+            });
+
+            delete sigs;
+            destroyer.join();
+        }
+    });
+
+    report("teardown_race", policy, 1, objects, 2, ns);
+}
+
+// A receiver whose slot takes its own lock, as one making a queued connection to its receiver
+// does, and which disconnects first thing in its destructor, as one called from other threads
+// must.
+template<class mt_policy>
+class LockingReceiver : public sigslot::has_slots<mt_policy>
+{
+public:
+    ~LockingReceiver()
+    {
+        this->disconnect();
+    }
+
+    void OnValue(int)
+    {
+        this->make_token();
+        ++counter();
+    }
+};
+
+// A stress test of teardown during emits. One thread emits every signal until half the
+// receivers are gone and then destroys the signals, while another destroys the receivers, so
+// that receivers are torn down both under running emits and as their signals go away. A
+// deadlock aborts the run after ten seconds; run under AddressSanitizer or ThreadSanitizer to
+// catch a receiver touching a destroyed signal. Reports the wall time per object destroyed.
+template<class mt_policy>
+void bench_teardown_emit(const char* policy)
+{
+    static const size_t objects = 32;
+
+    if(!selected("teardown_emit", policy))
+        return;
+
+    struct Signals
+    {
+        sigslot::basic_signal<mt_policy, int> sig[objects];
+    };
+
+    double ns = measure([&](long iterations)
+    {
+        for(long n = 0; n < iterations; n += objects * 2)
+        {
+            Watchdog watchdog("teardown_emit", policy, 10);
+            Signals* sigs = new Signals;
+            std::vector<LockingReceiver<mt_policy>*> receivers;
+            std::atomic<size_t> destroyed(0);
+
+            for(size_t r = 0; r < objects; ++r)
+            {
+                receivers.push_back(new LockingReceiver<mt_policy>);
+
+                for(size_t s = 0; s < objects; ++s)
+                    sigs->sig[s].connect(receivers[r], &LockingReceiver<mt_policy>::OnValue);
+            }
+
+            std::thread emitter([sigs, &destroyed]()
+            {
+                while(destroyed.load() < objects / 2)
+                {
+                    for(size_t s = 0; s < objects; ++s)
+                        sigs->sig[s].emit(1);
+                }
+
+                delete sigs;
+            });
+
+            for(size_t r = 0; r < receivers.size(); ++r)
+            {
+                delete receivers[r];
+                destroyed.fetch_add(1);
+            }
+
+            emitter.join();
+        }
+    });
+
+    report("teardown_emit", policy, 1, objects, 2, ns);
+}
+#endif
+
+// Fixed wiring through basic_static_signal, for comparison with the single_threaded emits.
+static void bench_static()
+{
+    typedef Receiver<sigslot::single_threaded> receiver_type;
+    typedef sigslot::static_slot<void (receiver_type::*)(int),
+        &receiver_type::template OnValue<int> > slot_type;
+
+    if(!selected("static_emit", "static"))
+        return;
+
+    receiver_type r[8];
+    sigslot::basic_static_signal<slot_type> one(&r[0]);
+    sigslot::basic_static_signal<slot_type, slot_type, slot_type, slot_type, slot_type, slot_type,
+        slot_type, slot_type> eight(&r[0], &r[1], &r[2], &r[3], &r[4], &r[5], &r[6], &r[7]);
+
+    double ns = measure([&](long iterations)
+    {
+        for(long n = 0; n < iterations; ++n)
+            one.emit(1);
+    });
+
+    report("static_emit", "static", 1, 1, 1, ns);
+
+    ns = measure([&](long iterations)
+    {
+        for(long n = 0; n < iterations; ++n)
+            eight.emit(1);
+    });
+
+    report("static_emit", "static", 1, 8, 1, ns);
+}
+
+// Contended emits only make sense for the policies that allow them.
+template<class mt_policy>
+void run(const char* policy, bool threaded = true)
+{
+    bench_arities<mt_policy>(policy);
+#ifndef _SIGSLOT_SINGLE_THREADED
+    if(threaded)
+    {
+        bench_contended<mt_policy>(policy);
+        bench_teardown_race<mt_policy>(policy);
+        bench_teardown_emit<mt_policy>(policy);
+    }
+#else
+    (void)threaded;
+#endif
+    bench_keyed<mt_policy>(policy);
+    bench_churn<mt_policy>(policy);
+    bench_bulk<mt_policy>(policy);
+    bench_teardown<mt_policy>(policy);
+}
+
+int main(int argc, char* argv[])
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--quick") == 0)
+            g_min_time = 0.02;
+        else
+            g_filter = argv[i];
+    }
+
+    printf("benchmark,policy,args,slots,threads,ns_per_op,ops_per_sec\n");
+
+    run<sigslot::single_threaded>("single_threaded", false);
+    bench_static();
+#ifndef _SIGSLOT_SINGLE_THREADED
+    run<sigslot::multi_threaded_global>("multi_threaded_global");
+    run<sigslot::multi_threaded_local>("multi_threaded_local");
+    run<sigslot::multi_threaded_rw>("multi_threaded_rw");
+    run<sigslot::multi_threaded_spin>("multi_threaded_spin");
+    run<sigslot::multi_threaded_striped<> >("multi_threaded_striped");
+    run<sigslot::snapshot_emit<sigslot::multi_threaded_local> >("snapshot_emit");
+    run<sigslot::multi_threaded_lockfree>("multi_threaded_lockfree");
+#endif
+    return 0;
+}
@@ -0,0 +1,10 @@
+TEMPLATE = app
+CONFIG += console c++11 release
+CONFIG -= app_bundle
+CONFIG -= qt
+
+SOURCES += \
+        benchmark.cpp
+
+HEADERS += \
+    sigslot.h
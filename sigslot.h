@@ -1,1419 +1,6774 @@
-// sigslot.h: Signal/Slot classes
-//
-// Written by Sarah Thompson (sarah@telergy.com) 2002.
-//
-// License: Public domain. You are free to use this code however you like, with the proviso that
-//          the author takes on no responsibility or liability for any use.
-//
-// QUICK DOCUMENTATION
-//
-//                (see also the full documentation at http://sigslot.sourceforge.net/)
-//
-//        #define switches
-//            SIGSLOT_PURE_ISO            - Define this to force ISO C++ compliance. This also disables
-//                                          all of the thread safety support on platforms where it is
-//                                          available.
-//
-//            SIGSLOT_USE_POSIX_THREADS   - Force use of Posix threads when using a C++ compiler other than
-//                                          gcc on a platform that supports Posix threads. (When using gcc,
-//                                          this is the default - use SIGSLOT_PURE_ISO to disable this if
-//                                          necessary)
-//
-//            SIGSLOT_DEFAULT_MT_POLICY   - Where thread support is enabled, this defaults to multi_threaded_global.
-//                                          Otherwise, the default is single_threaded. #define this yourself to
-//                                          override the default. In pure ISO mode, anything other than
-//                                          single_threaded will cause a compiler error.
-//
-//        PLATFORM NOTES
-//
-//            Win32                       - On Win32, the WIN32 symbol must be #defined. Most mainstream
-//                                          compilers do this by default, but you may need to define it
-//                                          yourself if your build environment is less standard. This causes
-//                                          the Win32 thread support to be compiled in and used automatically.
-//
-//            Unix/Linux/BSD, etc.        - If you're using gcc, it is assumed that you have Posix threads
-//                                          available, so they are used automatically. You can override this
-//                                          (as under Windows) with the SIGSLOT_PURE_ISO switch. If you're using
-//                                          something other than gcc but still want to use Posix threads, you
-//                                          need to #define SIGSLOT_USE_POSIX_THREADS.
-//
-//            ISO C++                     - If none of the supported platforms are detected, or if
-//                                          SIGSLOT_PURE_ISO is defined, all multithreading support is turned off,
-//                                          along with any code that might cause a pure ISO C++ environment to
-//                                          complain. Before you ask, gcc -ansi -pedantic won't compile this
-//                                          library, but gcc -ansi is fine. Pedantic mode seems to throw a lot of
-//                                          errors that aren't really there. If you feel like investigating this,
-//                                          please contact the author.
-//
-//
-//        THREADING MODES
-//
-//            single_threaded             - Your program is assumed to be single threaded from the point of view
-//                                          of signal/slot usage (i.e. all objects using signals and slots are
-//                                          created and destroyed from a single thread). Behaviour if objects are
-//                                          destroyed concurrently is undefined (i.e. you'll get the occasional
-//                                          segmentation fault/memory exception).
-//
-//            multi_threaded_global       - Your program is assumed to be multi threaded. Objects using signals and
-//                                          slots can be safely created and destroyed from any thread, even when
-//                                          connections exist. In multi_threaded_global mode, this is achieved by a
-//                                          single global mutex (actually a critical section on Windows because they
-//                                          are faster). This option uses less OS resources, but results in more
-//                                          opportunities for contention, possibly resulting in more context switches
-//                                          than are strictly necessary.
-//
-//            multi_threaded_local        - Behaviour in this mode is essentially the same as multi_threaded_global,
-//                                          except that each signal, and each object that inherits has_slots, all
-//                                          have their own mutex/critical section. In practice, this means that
-//                                          mutex collisions (and hence context switches) only happen if they are
-//                                          absolutely essential. However, on some platforms, creating a lot of
-//                                          mutexes can slow down the whole OS, so use this option with care.
-//
-//        USING THE LIBRARY
-//
-//        See the full documentation at http://sigslot.sourceforge.net/
-//
-//
-
-#ifndef SIGSLOT_H__
-#define SIGSLOT_H__
-
-#include <set>
-#include <list>
-
-#if defined(SIGSLOT_PURE_ISO) || (!defined(WIN32) && !defined(__GNUG__) && !defined(SIGSLOT_USE_POSIX_THREADS))
-#    define _SIGSLOT_SINGLE_THREADED
-#elif defined(WIN32)
-#    define _SIGSLOT_HAS_WIN32_THREADS
-#    include <windows.h>
-#elif defined(__GNUG__) || defined(SIGSLOT_USE_POSIX_THREADS)
-#    define _SIGSLOT_HAS_POSIX_THREADS
-#    include <pthread.h>
-#else
-#    define _SIGSLOT_SINGLE_THREADED
-#endif
-
-#ifndef SIGSLOT_DEFAULT_MT_POLICY
-#    ifdef _SIGSLOT_SINGLE_THREADED
-#        define SIGSLOT_DEFAULT_MT_POLICY single_threaded
-#    else
-#        define SIGSLOT_DEFAULT_MT_POLICY multi_threaded_local
-#    endif
-#endif
-
-
-namespace sigslot {
-
-    class single_threaded
-    {
-    public:
-        single_threaded()
-        {
-        }
-
-        virtual ~single_threaded()
-        {
-        }
-
-        virtual void lock()
-        {
-        }
-
-        virtual void unlock()
-        {
-        }
-    };
-
-#ifdef _SIGSLOT_HAS_WIN32_THREADS
-    // The multi threading policies only get compiled in if they are enabled.
-    class multi_threaded_global
-    {
-    public:
-        multi_threaded_global()
-        {
-            static bool isinitialised = false;
-
-            if(!isinitialised)
-            {
-                InitializeCriticalSection(get_critsec());
-                isinitialised = true;
-            }
-        }
-
-        multi_threaded_global(const multi_threaded_global&)
-        {
-        }
-
-        virtual ~multi_threaded_global()
-        {
-        }
-
-        virtual void lock()
-        {
-            EnterCriticalSection(get_critsec());
-        }
-
-        virtual void unlock()
-        {
-            LeaveCriticalSection(get_critsec());
-        }
-
-    private:
-        CRITICAL_SECTION* get_critsec()
-        {
-            static CRITICAL_SECTION g_critsec;
-            return &g_critsec;
-        }
-    };
-
-    class multi_threaded_local
-    {
-    public:
-        multi_threaded_local()
-        {
-            InitializeCriticalSection(&m_critsec);
-        }
-
-        multi_threaded_local(const multi_threaded_local&)
-        {
-            InitializeCriticalSection(&m_critsec);
-        }
-
-        virtual ~multi_threaded_local()
-        {
-            DeleteCriticalSection(&m_critsec);
-        }
-
-        virtual void lock()
-        {
-            EnterCriticalSection(&m_critsec);
-        }
-
-        virtual void unlock()
-        {
-            LeaveCriticalSection(&m_critsec);
-        }
-
-    private:
-        CRITICAL_SECTION m_critsec;
-    };
-#endif // _SIGSLOT_HAS_WIN32_THREADS
-
-#ifdef _SIGSLOT_HAS_POSIX_THREADS
-    // The multi threading policies only get compiled in if they are enabled.
-    class multi_threaded_global
-    {
-    public:
-        multi_threaded_global()
-        {
-            pthread_mutex_init(get_mutex(), NULL);
-        }
-
-        multi_threaded_global(const multi_threaded_global&)
-        {
-        }
-
-        virtual ~multi_threaded_global()
-        {
-        }
-
-        virtual void lock()
-        {
-            pthread_mutex_lock(get_mutex());
-        }
-
-        virtual void unlock()
-        {
-            pthread_mutex_unlock(get_mutex());
-        }
-
-    private:
-        pthread_mutex_t* get_mutex()
-        {
-            static pthread_mutex_t g_mutex;
-            return &g_mutex;
-        }
-    };
-
-    class multi_threaded_local
-    {
-    public:
-        multi_threaded_local()
-        {
-            pthread_mutex_init(&m_mutex, NULL);
-        }
-
-        multi_threaded_local(const multi_threaded_local&)
-        {
-            pthread_mutex_init(&m_mutex, NULL);
-        }
-
-        virtual ~multi_threaded_local()
-        {
-            pthread_mutex_destroy(&m_mutex);
-        }
-
-        virtual void lock()
-        {
-            pthread_mutex_lock(&m_mutex);
-        }
-
-        virtual void unlock()
-        {
-            pthread_mutex_unlock(&m_mutex);
-        }
-
-    private:
-        pthread_mutex_t m_mutex;
-    };
-#endif // _SIGSLOT_HAS_POSIX_THREADS
-
-    template<class mt_policy>
-    class lock_block
-    {
-    public:
-        mt_policy *m_mutex;
-
-        lock_block(mt_policy *mtx)
-            : m_mutex(mtx)
-        {
-            m_mutex->lock();
-        }
-
-        ~lock_block()
-        {
-            m_mutex->unlock();
-        }
-    };
-
-    template<class mt_policy>
-    class has_slots;
-
-    template<class mt_policy>
-    class _signal_base : public mt_policy
-    {
-    public:
-        virtual void disconnect(has_slots<mt_policy>* pslot) = 0;
-    };
-
-    template<class mt_policy>
-    class _connection_base0
-    {
-    public:
-        virtual ~_connection_base0() {}
-        virtual has_slots<mt_policy>* getdest() const = 0;
-        virtual void emit() = 0;
-    };
-
-    template<class arg1_type, class mt_policy>
-    class _connection_base1
-    {
-    public:
-        virtual ~_connection_base1() {}
-        virtual has_slots<mt_policy>* getdest() const = 0;
-        virtual void emit(arg1_type) = 0;
-    };
-
-    template<class arg1_type, class arg2_type, class mt_policy>
-    class _connection_base2
-    {
-    public:
-        virtual ~_connection_base2() {}
-        virtual has_slots<mt_policy>* getdest() const = 0;
-        virtual void emit(arg1_type, arg2_type) = 0;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class mt_policy>
-    class _connection_base3
-    {
-    public:
-        virtual ~_connection_base3() {}
-        virtual has_slots<mt_policy>* getdest() const = 0;
-        virtual void emit(arg1_type, arg2_type, arg3_type) = 0;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type, class mt_policy>
-    class _connection_base4
-    {
-    public:
-        virtual ~_connection_base4() {}
-        virtual has_slots<mt_policy>* getdest() const = 0;
-        virtual void emit(arg1_type, arg2_type, arg3_type, arg4_type) = 0;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
-    class arg5_type, class mt_policy>
-    class _connection_base5
-    {
-    public:
-        virtual ~_connection_base5() {}
-        virtual has_slots<mt_policy>* getdest() const = 0;
-        virtual void emit(arg1_type, arg2_type, arg3_type, arg4_type,
-            arg5_type) = 0;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
-    class arg5_type, class arg6_type, class mt_policy>
-    class _connection_base6
-    {
-    public:
-        virtual ~_connection_base6() {}
-        virtual has_slots<mt_policy>* getdest() const = 0;
-        virtual void emit(arg1_type, arg2_type, arg3_type, arg4_type, arg5_type,
-            arg6_type) = 0;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
-    class arg5_type, class arg6_type, class arg7_type, class mt_policy>
-    class _connection_base7
-    {
-    public:
-        virtual ~_connection_base7() {}
-        virtual has_slots<mt_policy>* getdest() const = 0;
-        virtual void emit(arg1_type, arg2_type, arg3_type, arg4_type, arg5_type,
-            arg6_type, arg7_type) = 0;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
-    class arg5_type, class arg6_type, class arg7_type, class arg8_type, class mt_policy>
-    class _connection_base8
-    {
-    public:
-        virtual ~_connection_base8() {}
-        virtual has_slots<mt_policy>* getdest() const = 0;
-        virtual void emit(arg1_type, arg2_type, arg3_type, arg4_type, arg5_type,
-            arg6_type, arg7_type, arg8_type) = 0;
-    };
-
-    template<class dest_type, class mt_policy>
-    class _connection0 : public _connection_base0<mt_policy>
-    {
-    public:
-        _connection0(dest_type* pobject, void (dest_type::*pmemfun)())
-        {
-            m_pobject = pobject;
-            m_pmemfun = pmemfun;
-        }
-
-        virtual void emit()
-        {
-            (m_pobject->*m_pmemfun)();
-        }
-
-        virtual has_slots<mt_policy>* getdest() const
-        {
-            return m_pobject;
-        }
-
-    private:
-        dest_type* m_pobject;
-        void (dest_type::* m_pmemfun)();
-    };
-
-    template<class dest_type, class arg1_type, class mt_policy>
-    class _connection1 : public _connection_base1<arg1_type, mt_policy>
-    {
-    public:
-        _connection1(dest_type* pobject, void (dest_type::*pmemfun)(arg1_type))
-        {
-            m_pobject = pobject;
-            m_pmemfun = pmemfun;
-        }
-
-        virtual void emit(arg1_type a1)
-        {
-            (m_pobject->*m_pmemfun)(a1);
-        }
-
-        virtual has_slots<mt_policy>* getdest() const
-        {
-            return m_pobject;
-        }
-
-    private:
-        dest_type* m_pobject;
-        void (dest_type::* m_pmemfun)(arg1_type);
-    };
-
-    template<class dest_type, class arg1_type, class arg2_type, class mt_policy>
-    class _connection2 : public _connection_base2<arg1_type, arg2_type, mt_policy>
-    {
-    public:
-        _connection2(dest_type* pobject, void (dest_type::*pmemfun)(arg1_type,
-            arg2_type))
-        {
-            m_pobject = pobject;
-            m_pmemfun = pmemfun;
-        }
-
-        virtual void emit(arg1_type a1, arg2_type a2)
-        {
-            (m_pobject->*m_pmemfun)(a1, a2);
-        }
-
-        virtual has_slots<mt_policy>* getdest() const
-        {
-            return m_pobject;
-        }
-
-    private:
-        dest_type* m_pobject;
-        void (dest_type::* m_pmemfun)(arg1_type, arg2_type);
-    };
-
-    template<class dest_type, class arg1_type, class arg2_type, class arg3_type, class mt_policy>
-    class _connection3 : public _connection_base3<arg1_type, arg2_type, arg3_type, mt_policy>
-    {
-    public:
-        _connection3(dest_type* pobject, void (dest_type::*pmemfun)(arg1_type,
-            arg2_type, arg3_type))
-        {
-            m_pobject = pobject;
-            m_pmemfun = pmemfun;
-        }
-
-        virtual void emit(arg1_type a1, arg2_type a2, arg3_type a3)
-        {
-            (m_pobject->*m_pmemfun)(a1, a2, a3);
-        }
-
-        virtual has_slots<mt_policy>* getdest() const
-        {
-            return m_pobject;
-        }
-
-    private:
-        dest_type* m_pobject;
-        void (dest_type::* m_pmemfun)(arg1_type, arg2_type, arg3_type);
-    };
-
-    template<class dest_type, class arg1_type, class arg2_type, class arg3_type,
-    class arg4_type, class mt_policy>
-    class _connection4 : public _connection_base4<arg1_type, arg2_type,
-        arg3_type, arg4_type, mt_policy>
-    {
-    public:
-        _connection4(dest_type* pobject, void (dest_type::*pmemfun)(arg1_type,
-            arg2_type, arg3_type, arg4_type))
-        {
-            m_pobject = pobject;
-            m_pmemfun = pmemfun;
-        }
-
-        virtual void emit(arg1_type a1, arg2_type a2, arg3_type a3,
-            arg4_type a4)
-        {
-            (m_pobject->*m_pmemfun)(a1, a2, a3, a4);
-        }
-
-        virtual has_slots<mt_policy>* getdest() const
-        {
-            return m_pobject;
-        }
-
-    private:
-        dest_type* m_pobject;
-        void (dest_type::* m_pmemfun)(arg1_type, arg2_type, arg3_type,
-            arg4_type);
-    };
-
-    template<class dest_type, class arg1_type, class arg2_type, class arg3_type,
-    class arg4_type, class arg5_type, class mt_policy>
-    class _connection5 : public _connection_base5<arg1_type, arg2_type,
-        arg3_type, arg4_type, arg5_type, mt_policy>
-    {
-    public:
-        _connection5(dest_type* pobject, void (dest_type::*pmemfun)(arg1_type,
-            arg2_type, arg3_type, arg4_type, arg5_type))
-        {
-            m_pobject = pobject;
-            m_pmemfun = pmemfun;
-        }
-
-        virtual void emit(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5)
-        {
-            (m_pobject->*m_pmemfun)(a1, a2, a3, a4, a5);
-        }
-
-        virtual has_slots<mt_policy>* getdest() const
-        {
-            return m_pobject;
-        }
-
-    private:
-        dest_type* m_pobject;
-        void (dest_type::* m_pmemfun)(arg1_type, arg2_type, arg3_type, arg4_type,
-            arg5_type);
-    };
-
-    template<class dest_type, class arg1_type, class arg2_type, class arg3_type,
-    class arg4_type, class arg5_type, class arg6_type, class mt_policy>
-    class _connection6 : public _connection_base6<arg1_type, arg2_type,
-        arg3_type, arg4_type, arg5_type, arg6_type, mt_policy>
-    {
-    public:
-        _connection6(dest_type* pobject, void (dest_type::*pmemfun)(arg1_type,
-            arg2_type, arg3_type, arg4_type, arg5_type, arg6_type))
-        {
-            m_pobject = pobject;
-            m_pmemfun = pmemfun;
-        }
-
-        virtual void emit(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5, arg6_type a6)
-        {
-            (m_pobject->*m_pmemfun)(a1, a2, a3, a4, a5, a6);
-        }
-
-        virtual has_slots<mt_policy>* getdest() const
-        {
-            return m_pobject;
-        }
-
-    private:
-        dest_type* m_pobject;
-        void (dest_type::* m_pmemfun)(arg1_type, arg2_type, arg3_type, arg4_type,
-            arg5_type, arg6_type);
-    };
-
-    template<class dest_type, class arg1_type, class arg2_type, class arg3_type,
-    class arg4_type, class arg5_type, class arg6_type, class arg7_type, class mt_policy>
-    class _connection7 : public _connection_base7<arg1_type, arg2_type,
-        arg3_type, arg4_type, arg5_type, arg6_type, arg7_type, mt_policy>
-    {
-    public:
-        _connection7(dest_type* pobject, void (dest_type::*pmemfun)(arg1_type,
-            arg2_type, arg3_type, arg4_type, arg5_type, arg6_type, arg7_type))
-        {
-            m_pobject = pobject;
-            m_pmemfun = pmemfun;
-        }
-
-        virtual void emit(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5, arg6_type a6, arg7_type a7)
-        {
-            (m_pobject->*m_pmemfun)(a1, a2, a3, a4, a5, a6, a7);
-        }
-
-        virtual has_slots<mt_policy>* getdest() const
-        {
-            return m_pobject;
-        }
-
-    private:
-        dest_type* m_pobject;
-        void (dest_type::* m_pmemfun)(arg1_type, arg2_type, arg3_type, arg4_type,
-            arg5_type, arg6_type, arg7_type);
-    };
-
-    template<class dest_type, class arg1_type, class arg2_type, class arg3_type,
-    class arg4_type, class arg5_type, class arg6_type, class arg7_type,
-    class arg8_type, class mt_policy>
-    class _connection8 : public _connection_base8<arg1_type, arg2_type,
-        arg3_type, arg4_type, arg5_type, arg6_type, arg7_type, arg8_type, mt_policy>
-    {
-    public:
-        _connection8(dest_type* pobject, void (dest_type::*pmemfun)(arg1_type,
-            arg2_type, arg3_type, arg4_type, arg5_type, arg6_type,
-            arg7_type, arg8_type))
-        {
-            m_pobject = pobject;
-            m_pmemfun = pmemfun;
-        }
-
-        virtual void emit(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5, arg6_type a6, arg7_type a7, arg8_type a8)
-        {
-            (m_pobject->*m_pmemfun)(a1, a2, a3, a4, a5, a6, a7, a8);
-        }
-
-        virtual has_slots<mt_policy>* getdest() const
-        {
-            return m_pobject;
-        }
-
-    private:
-        dest_type* m_pobject;
-        void (dest_type::* m_pmemfun)(arg1_type, arg2_type, arg3_type, arg4_type,
-            arg5_type, arg6_type, arg7_type, arg8_type);
-    };
-
-    template<class mt_policy= SIGSLOT_DEFAULT_MT_POLICY>
-    class signal0 : public _signal_base<mt_policy>
-    {
-    public:
-        typedef typename std::list<_connection_base0<mt_policy> *>  connections_list;
-        ~signal0()
-        {
-            signal_destroy(true);
-        }
-
-        template<class desttype>
-        void connect(desttype* pclass, void (desttype::*pmemfun)())
-        {
-            lock_block<mt_policy> lock(this);
-            _connection0<desttype, mt_policy>* conn =
-                new _connection0<desttype, mt_policy>(pclass, pmemfun);
-            m_connected_slots.push_back(conn);
-            pclass->signal_connect(this);
-        }
-
-        void emit()
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::const_iterator itNext, it = m_connected_slots.begin();
-            typename connections_list::const_iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                itNext = it;
-                ++itNext;
-
-                (*it)->emit();
-
-                it = itNext;
-            }
-        }
-
-        void operator()()
-        {
-            emit();
-        }
-
-        void disconnect(has_slots<mt_policy>* pslot = NULL)
-        {
-            signal_destroy(false, pslot);
-        }
-
-    private:
-        void signal_destroy(bool destroy, has_slots<mt_policy>* pslot = NULL)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::iterator it = m_connected_slots.begin();
-            typename connections_list::iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                typename connections_list::iterator itNext = it;
-                ++itNext;
-
-                if (destroy)
-                    (*it)->getdest()->signal_disconnect(this);
-
-                if(pslot == NULL || (*it)->getdest() == pslot)
-                {
-                    delete *it;
-                    m_connected_slots.erase(it);
-                }
-
-                it = itNext;
-            }
-        }
-
-    protected:
-        connections_list m_connected_slots;
-    };
-
-    template<class arg1_type, class mt_policy= SIGSLOT_DEFAULT_MT_POLICY>
-    class signal1 : public _signal_base<mt_policy>
-    {
-    public:
-        typedef typename std::list<_connection_base1<arg1_type, mt_policy> *>  connections_list;
-
-        ~signal1()
-        {
-            signal_destroy(true);
-        }
-
-        template<class desttype>
-        void connect(desttype* pclass, void (desttype::*pmemfun)(arg1_type))
-        {
-            lock_block<mt_policy> lock(this);
-            _connection1<desttype, arg1_type, mt_policy>* conn =
-                new _connection1<desttype, arg1_type, mt_policy>(pclass, pmemfun);
-            m_connected_slots.push_back(conn);
-            pclass->signal_connect(this);
-        }
-
-        void emit(arg1_type a1)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::const_iterator itNext, it = m_connected_slots.begin();
-            typename connections_list::const_iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                itNext = it;
-                ++itNext;
-
-                (*it)->emit(a1);
-
-                it = itNext;
-            }
-        }
-
-        void operator()(arg1_type a1)
-        {
-            emit(a1);
-        }
-
-        void disconnect(has_slots<mt_policy>* pslot = NULL)
-        {
-            signal_destroy(false, pslot);
-        }
-
-    private:
-        void signal_destroy(bool destroy, has_slots<mt_policy>* pslot = NULL)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::iterator it = m_connected_slots.begin();
-            typename connections_list::iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                typename connections_list::iterator itNext = it;
-                ++itNext;
-
-                if (destroy)
-                    (*it)->getdest()->signal_disconnect(this);
-
-                if(pslot == NULL || (*it)->getdest() == pslot)
-                {
-                    delete *it;
-                    m_connected_slots.erase(it);
-                }
-
-                it = itNext;
-            }
-        }
-
-
-    protected:
-        connections_list m_connected_slots;
-    };
-
-    template<class arg1_type, class arg2_type, class mt_policy= SIGSLOT_DEFAULT_MT_POLICY>
-    class signal2 : public _signal_base<mt_policy>
-    {
-    public:
-        typedef typename std::list<_connection_base2<arg1_type, arg2_type, mt_policy> *>
-            connections_list;
-
-        ~signal2()
-        {
-            signal_destroy(true);
-        }
-
-        template<class desttype>
-        void connect(desttype* pclass, void (desttype::*pmemfun)(arg1_type,
-        arg2_type))
-        {
-            lock_block<mt_policy> lock(this);
-            _connection2<desttype, arg1_type, arg2_type, mt_policy>* conn = new
-                _connection2<desttype, arg1_type, arg2_type, mt_policy>(pclass, pmemfun);
-            m_connected_slots.push_back(conn);
-            pclass->signal_connect(this);
-        }
-
-        void emit(arg1_type a1, arg2_type a2)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::const_iterator itNext, it = m_connected_slots.begin();
-            typename connections_list::const_iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                itNext = it;
-                ++itNext;
-
-                (*it)->emit(a1, a2);
-
-                it = itNext;
-            }
-        }
-
-        void operator()(arg1_type a1, arg2_type a2)
-        {
-            emit(a1, a2);
-        }
-
-        void disconnect(has_slots<mt_policy>* pslot = NULL)
-        {
-            signal_destroy(false, pslot);
-        }
-
-    private:
-        void signal_destroy(bool destroy, has_slots<mt_policy>* pslot = NULL)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::iterator it = m_connected_slots.begin();
-            typename connections_list::iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                typename connections_list::iterator itNext = it;
-                ++itNext;
-
-                if (destroy)
-                    (*it)->getdest()->signal_disconnect(this);
-
-                if(pslot == NULL || (*it)->getdest() == pslot)
-                {
-                    delete *it;
-                    m_connected_slots.erase(it);
-                }
-
-                it = itNext;
-            }
-        }
-
-    protected:
-        connections_list m_connected_slots;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class mt_policy= SIGSLOT_DEFAULT_MT_POLICY>
-    class signal3 : public _signal_base<mt_policy>
-    {
-    public:
-        typedef typename std::list<_connection_base3<arg1_type, arg2_type, arg3_type, mt_policy> *>
-            connections_list;
-
-        ~signal3()
-        {
-            signal_destroy(true);
-        }
-
-        template<class desttype>
-        void connect(desttype* pclass, void (desttype::*pmemfun)(arg1_type,
-        arg2_type, arg3_type))
-        {
-            lock_block<mt_policy> lock(this);
-            _connection3<desttype, arg1_type, arg2_type, arg3_type, mt_policy>* conn =
-                new _connection3<desttype, arg1_type, arg2_type, arg3_type, mt_policy>(pclass,
-                pmemfun);
-            m_connected_slots.push_back(conn);
-            pclass->signal_connect(this);
-        }
-
-        void emit(arg1_type a1, arg2_type a2, arg3_type a3)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::const_iterator itNext, it = m_connected_slots.begin();
-            typename connections_list::const_iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                itNext = it;
-                ++itNext;
-
-                (*it)->emit(a1, a2, a3);
-
-                it = itNext;
-            }
-        }
-
-        void operator()(arg1_type a1, arg2_type a2, arg3_type a3)
-        {
-            emit(a1, a2, a3);
-        }
-
-        void disconnect(has_slots<mt_policy>* pslot = NULL)
-        {
-            signal_destroy(false, pslot);
-        }
-
-    private:
-        void signal_destroy(bool destroy, has_slots<mt_policy>* pslot = NULL)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::iterator it = m_connected_slots.begin();
-            typename connections_list::iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                typename connections_list::iterator itNext = it;
-                ++itNext;
-
-                if (destroy)
-                    (*it)->getdest()->signal_disconnect(this);
-
-                if(pslot == NULL || (*it)->getdest() == pslot)
-                {
-                    delete *it;
-                    m_connected_slots.erase(it);
-                }
-
-                it = itNext;
-            }
-        }
-
-    protected:
-        connections_list m_connected_slots;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type, class mt_policy= SIGSLOT_DEFAULT_MT_POLICY>
-    class signal4 : public _signal_base<mt_policy>
-    {
-    public:
-        typedef typename std::list<_connection_base4<arg1_type, arg2_type, arg3_type,
-            arg4_type, mt_policy> *>  connections_list;
-
-        ~signal4()
-        {
-            signal_destroy(true);
-        }
-
-        template<class desttype>
-        void connect(desttype* pclass, void (desttype::*pmemfun)(arg1_type,
-        arg2_type, arg3_type, arg4_type))
-        {
-            lock_block<mt_policy> lock(this);
-            _connection4<desttype, arg1_type, arg2_type, arg3_type, arg4_type, mt_policy>*
-                conn = new _connection4<desttype, arg1_type, arg2_type, arg3_type,
-                arg4_type, mt_policy>(pclass, pmemfun);
-            m_connected_slots.push_back(conn);
-            pclass->signal_connect(this);
-        }
-
-        void emit(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::const_iterator itNext, it = m_connected_slots.begin();
-            typename connections_list::const_iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                itNext = it;
-                ++itNext;
-
-                (*it)->emit(a1, a2, a3, a4);
-
-                it = itNext;
-            }
-        }
-
-        void operator()(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4)
-        {
-            emit(a1, a2, a3, a4);
-        }
-
-        void disconnect(has_slots<mt_policy>* pslot = NULL)
-        {
-            signal_destroy(false, pslot);
-        }
-
-    private:
-        void signal_destroy(bool destroy, has_slots<mt_policy>* pslot = NULL)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::iterator it = m_connected_slots.begin();
-            typename connections_list::iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                typename connections_list::iterator itNext = it;
-                ++itNext;
-
-                if (destroy)
-                    (*it)->getdest()->signal_disconnect(this);
-
-                if(pslot == NULL || (*it)->getdest() == pslot)
-                {
-                    delete *it;
-                    m_connected_slots.erase(it);
-                }
-
-                it = itNext;
-            }
-        }
-
-    protected:
-        connections_list m_connected_slots;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
-    class arg5_type, class mt_policy= SIGSLOT_DEFAULT_MT_POLICY>
-    class signal5 : public _signal_base<mt_policy>
-    {
-    public:
-        typedef typename std::list<_connection_base5<arg1_type, arg2_type, arg3_type,
-            arg4_type, arg5_type, mt_policy> *>  connections_list;
-
-        ~signal5()
-        {
-            signal_destroy(true);
-        }
-
-        template<class desttype>
-        void connect(desttype* pclass, void (desttype::*pmemfun)(arg1_type,
-        arg2_type, arg3_type, arg4_type, arg5_type))
-        {
-            lock_block<mt_policy> lock(this);
-            _connection5<desttype, arg1_type, arg2_type, arg3_type, arg4_type,
-                arg5_type, mt_policy>* conn = new _connection5<desttype, arg1_type, arg2_type,
-                arg3_type, arg4_type, arg5_type, mt_policy>(pclass, pmemfun);
-            m_connected_slots.push_back(conn);
-            pclass->signal_connect(this);
-        }
-
-        void emit(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::const_iterator itNext, it = m_connected_slots.begin();
-            typename connections_list::const_iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                itNext = it;
-                ++itNext;
-
-                (*it)->emit(a1, a2, a3, a4, a5);
-
-                it = itNext;
-            }
-        }
-
-        void operator()(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5)
-        {
-            emit(a1, a2, a3, a4, a5);
-        }
-
-        void disconnect(has_slots<mt_policy>* pslot = NULL)
-        {
-            signal_destroy(false, pslot);
-        }
-
-    private:
-        void signal_destroy(bool destroy, has_slots<mt_policy>* pslot = NULL)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::iterator it = m_connected_slots.begin();
-            typename connections_list::iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                typename connections_list::iterator itNext = it;
-                ++itNext;
-
-                if (destroy)
-                    (*it)->getdest()->signal_disconnect(this);
-
-                if(pslot == NULL || (*it)->getdest() == pslot)
-                {
-                    delete *it;
-                    m_connected_slots.erase(it);
-                }
-
-                it = itNext;
-            }
-        }
-
-    protected:
-        connections_list m_connected_slots;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
-    class arg5_type, class arg6_type, class mt_policy= SIGSLOT_DEFAULT_MT_POLICY>
-    class signal6 : public _signal_base<mt_policy>
-    {
-    public:
-        typedef typename std::list<_connection_base6<arg1_type, arg2_type, arg3_type,
-            arg4_type, arg5_type, arg6_type, mt_policy> *>  connections_list;
-
-        ~signal6()
-        {
-            signal_destroy(true);
-        }
-
-        template<class desttype>
-        void connect(desttype* pclass, void (desttype::*pmemfun)(arg1_type,
-        arg2_type, arg3_type, arg4_type, arg5_type, arg6_type))
-        {
-            lock_block<mt_policy> lock(this);
-            _connection6<desttype, arg1_type, arg2_type, arg3_type, arg4_type,
-                arg5_type, arg6_type, mt_policy>* conn =
-                new _connection6<desttype, arg1_type, arg2_type, arg3_type,
-                arg4_type, arg5_type, arg6_type, mt_policy>(pclass, pmemfun);
-            m_connected_slots.push_back(conn);
-            pclass->signal_connect(this);
-        }
-
-        void emit(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5, arg6_type a6)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::const_iterator itNext, it = m_connected_slots.begin();
-            typename connections_list::const_iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                itNext = it;
-                ++itNext;
-
-                (*it)->emit(a1, a2, a3, a4, a5, a6);
-
-                it = itNext;
-            }
-        }
-
-        void operator()(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5, arg6_type a6)
-        {
-            emit(a1, a2, a3, a4, a5, a6);
-        }
-
-        void disconnect(has_slots<mt_policy>* pslot = NULL)
-        {
-            signal_destroy(false, pslot);
-        }
-
-    private:
-        void signal_destroy(bool destroy, has_slots<mt_policy>* pslot = NULL)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::iterator it = m_connected_slots.begin();
-            typename connections_list::iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                typename connections_list::iterator itNext = it;
-                ++itNext;
-
-                if (destroy)
-                    (*it)->getdest()->signal_disconnect(this);
-
-                if(pslot == NULL || (*it)->getdest() == pslot)
-                {
-                    delete *it;
-                    m_connected_slots.erase(it);
-                }
-
-                it = itNext;
-            }
-        }
-
-    protected:
-        connections_list m_connected_slots;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
-    class arg5_type, class arg6_type, class arg7_type, class mt_policy= SIGSLOT_DEFAULT_MT_POLICY>
-    class signal7 : public _signal_base<mt_policy>
-    {
-    public:
-        typedef typename std::list<_connection_base7<arg1_type, arg2_type, arg3_type,
-            arg4_type, arg5_type, arg6_type, arg7_type, mt_policy> *>  connections_list;
-
-        ~signal7()
-        {
-            signal_destroy(true);
-        }
-
-        template<class desttype>
-        void connect(desttype* pclass, void (desttype::*pmemfun)(arg1_type,
-        arg2_type, arg3_type, arg4_type, arg5_type, arg6_type,
-        arg7_type))
-        {
-            lock_block<mt_policy> lock(this);
-            _connection7<desttype, arg1_type, arg2_type, arg3_type, arg4_type,
-                arg5_type, arg6_type, arg7_type, mt_policy>* conn =
-                new _connection7<desttype, arg1_type, arg2_type, arg3_type,
-                arg4_type, arg5_type, arg6_type, arg7_type, mt_policy>(pclass, pmemfun);
-            m_connected_slots.push_back(conn);
-            pclass->signal_connect(this);
-        }
-
-        void emit(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5, arg6_type a6, arg7_type a7)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::const_iterator itNext, it = m_connected_slots.begin();
-            typename connections_list::const_iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                itNext = it;
-                ++itNext;
-
-                (*it)->emit(a1, a2, a3, a4, a5, a6, a7);
-
-                it = itNext;
-            }
-        }
-
-        void operator()(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5, arg6_type a6, arg7_type a7)
-        {
-            emit(a1, a2, a3, a4, a5, a6, a7);
-        }
-
-        void disconnect(has_slots<mt_policy>* pslot = NULL)
-        {
-            signal_destroy(false, pslot);
-        }
-
-    private:
-        void signal_destroy(bool destroy, has_slots<mt_policy>* pslot = NULL)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::iterator it = m_connected_slots.begin();
-            typename connections_list::iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                typename connections_list::iterator itNext = it;
-                ++itNext;
-
-                if (destroy)
-                    (*it)->getdest()->signal_disconnect(this);
-
-                if(pslot == NULL || (*it)->getdest() == pslot)
-                {
-                    delete *it;
-                    m_connected_slots.erase(it);
-                }
-
-                it = itNext;
-            }
-        }
-
-    protected:
-        connections_list m_connected_slots;
-    };
-
-    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
-    class arg5_type, class arg6_type, class arg7_type, class arg8_type, class mt_policy= SIGSLOT_DEFAULT_MT_POLICY>
-    class signal8 : public _signal_base<mt_policy>
-    {
-    public:
-        typedef typename std::list<_connection_base8<arg1_type, arg2_type, arg3_type,
-            arg4_type, arg5_type, arg6_type, arg7_type, arg8_type, mt_policy> *>
-            connections_list;
-
-        ~signal8()
-        {
-            signal_destroy(true);
-        }
-
-        template<class desttype>
-        void connect(desttype* pclass, void (desttype::*pmemfun)(arg1_type,
-        arg2_type, arg3_type, arg4_type, arg5_type, arg6_type,
-        arg7_type, arg8_type))
-        {
-            lock_block<mt_policy> lock(this);
-            _connection8<desttype, arg1_type, arg2_type, arg3_type, arg4_type,
-                arg5_type, arg6_type, arg7_type, arg8_type, mt_policy>* conn =
-                new _connection8<desttype, arg1_type, arg2_type, arg3_type,
-                arg4_type, arg5_type, arg6_type, arg7_type,
-                arg8_type, mt_policy>(pclass, pmemfun);
-            m_connected_slots.push_back(conn);
-            pclass->signal_connect(this);
-        }
-
-        void emit(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5, arg6_type a6, arg7_type a7, arg8_type a8)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::const_iterator itNext, it = m_connected_slots.begin();
-            typename connections_list::const_iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                itNext = it;
-                ++itNext;
-
-                (*it)->emit(a1, a2, a3, a4, a5, a6, a7, a8);
-
-                it = itNext;
-            }
-        }
-
-        void operator()(arg1_type a1, arg2_type a2, arg3_type a3, arg4_type a4,
-            arg5_type a5, arg6_type a6, arg7_type a7, arg8_type a8)
-        {
-            emit(a1, a2, a3, a4, a5, a6, a7, a8);
-        }
-
-        void disconnect(has_slots<mt_policy>* pslot = NULL)
-        {
-            signal_destroy(false, pslot);
-        }
-
-    private:
-        void signal_destroy(bool destroy, has_slots<mt_policy>* pslot = NULL)
-        {
-            lock_block<mt_policy> lock(this);
-            typename connections_list::iterator it = m_connected_slots.begin();
-            typename connections_list::iterator itEnd = m_connected_slots.end();
-
-            while(it != itEnd)
-            {
-                typename connections_list::iterator itNext = it;
-                ++itNext;
-
-                if (destroy)
-                    (*it)->getdest()->signal_disconnect(this);
-
-                if(pslot == NULL || (*it)->getdest() == pslot)
-                {
-                    delete *it;
-                    m_connected_slots.erase(it);
-                }
-
-                it = itNext;
-            }
-        }
-
-    protected:
-        connections_list m_connected_slots;
-    };
-
-    template<class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
-    class has_slots : public mt_policy
-    {
-    private:
-        typedef std::set<_signal_base<mt_policy> *> sender_set;
-        typedef typename sender_set::const_iterator const_iterator;
-    public:
-        void signal_connect(_signal_base<mt_policy>* sender)
-        {
-            lock_block<mt_policy> lock(this);
-            m_senders.insert(sender);
-        }
-
-        void signal_disconnect(_signal_base<mt_policy>* sender)
-        {
-            lock_block<mt_policy> lock(this);
-            m_senders.erase(sender);
-        }
-
-        virtual ~has_slots()
-        {
-            disconnect();
-        }
-
-        void disconnect()
-        {
-            lock_block<mt_policy> lock(this);
-            const_iterator it = m_senders.begin();
-            const_iterator itEnd = m_senders.end();
-
-            while(it != itEnd)
-            {
-                (*it)->disconnect(this);
-                ++it;
-            }
-
-            m_senders.clear();
-        }
-
-    private:
-        sender_set m_senders;
-    };
-}; // namespace sigslot
-
-#endif // SIGSLOT_H__
-
+// sigslot.h: Signal/Slot classes
+//
+// Written by Sarah Thompson (sarah@telergy.com) 2002.
+//
+// License: Public domain. You are free to use this code however you like, with the proviso that
+//          the author takes on no responsibility or liability for any use.
+//
+// QUICK DOCUMENTATION
+//
+//                (see also the full documentation at http://sigslot.sourceforge.net/)
+//
+//        #define switches
+//            SIGSLOT_PURE_ISO            - Define this to force ISO C++ compliance. This also disables
+//                                          all of the thread safety support on platforms where it is
+//                                          available.
+//
+//            SIGSLOT_USE_POSIX_THREADS   - Force use of Posix threads when using a C++ compiler other than
+//                                          gcc on a platform that supports Posix threads. (When using gcc,
+//                                          this is the default - use SIGSLOT_PURE_ISO to disable this if
+//                                          necessary)
+//
+//            SIGSLOT_DEFAULT_MT_POLICY   - Where thread support is enabled, this defaults to multi_threaded_global.
+//                                          Otherwise, the default is single_threaded. #define this yourself to
+//                                          override the default, e.g. as multi_threaded_rw or multi_threaded_spin.
+//                                          In pure ISO mode, anything other than single_threaded will cause a
+//                                          compiler error.
+//
+//            SIGSLOT_ALLOCATOR           - The allocator template used for the library's internal storage: connection
+//                                          arrays, snapshots and the sender sets of has_slots. Defaults to
+//                                          std::allocator. #define it as sigslot::pool_allocator to serve these from
+//                                          per-thread slab pools instead of the general purpose heap.
+//
+//            SIGSLOT_STATIC_STORAGE      - For targets without a heap. Signals keep their connections in an array of
+//                                          SIGSLOT_MAX_SLOTS (8 by default) inside the signal, and receivers their
+//                                          senders in an array of SIGSLOT_MAX_SENDERS (8 by default), so that
+//                                          connect, emit and disconnect never allocate or throw. A connect that
+//                                          would overflow either returns a handle whose connected() is false.
+//                                          Only the locked threading modes are available; snapshot_emit,
+//                                          multi_threaded_lockfree and the features built on queues, keys and
+//                                          shared memory still allocate, as does disconnect_all_of, which sorts
+//                                          a copy of its range. connect_many stops once the signal is full.
+//
+//            SIGSLOT_MEMORY_STATS        - Keeps the process wide totals read by sigslot::memory_totals(): live and
+//                                          peak connections, bytes held from SIGSLOT_ALLOCATOR and slab memory taken
+//                                          by pool_allocator. Each connect, disconnect and allocation then updates a
+//                                          shared counter; without it the totals read 0 and cost nothing.
+//
+//        PLATFORM NOTES
+//
+//            Win32                       - On Win32, the WIN32 symbol must be #defined. Most mainstream
+//                                          compilers do this by default, but you may need to define it
+//                                          yourself if your build environment is less standard. This causes
+//                                          the Win32 thread support to be compiled in and used automatically.
+//
+//            Unix/Linux/BSD, etc.        - If you're using gcc, it is assumed that you have Posix threads
+//                                          available, so they are used automatically. You can override this
+//                                          (as under Windows) with the SIGSLOT_PURE_ISO switch. If you're using
+//                                          something other than gcc but still want to use Posix threads, you
+//                                          need to #define SIGSLOT_USE_POSIX_THREADS.
+//
+//            ISO C++                     - If none of the supported platforms are detected, or if
+//                                          SIGSLOT_PURE_ISO is defined, all multithreading support is turned off,
+//                                          along with any code that might cause a pure ISO C++ environment to
+//                                          complain. Before you ask, gcc -ansi -pedantic won't compile this
+//                                          library, but gcc -ansi is fine. Pedantic mode seems to throw a lot of
+//                                          errors that aren't really there. If you feel like investigating this,
+//                                          please contact the author.
+//
+//
+//        THREADING MODES
+//
+//            single_threaded             - Your program is assumed to be single threaded from the point of view
+//                                          of signal/slot usage (i.e. all objects using signals and slots are
+//                                          created and destroyed from a single thread). Behaviour if objects are
+//                                          destroyed concurrently is undefined (i.e. you'll get the occasional
+//                                          segmentation fault/memory exception).
+//
+//            multi_threaded_global       - Your program is assumed to be multi threaded. Objects using signals and
+//                                          slots can be safely created and destroyed from any thread, even when
+//                                          connections exist. In multi_threaded_global mode, this is achieved by a
+//                                          single global mutex (actually a critical section on Windows because they
+//                                          are faster). This option uses less OS resources, but results in more
+//                                          opportunities for contention, possibly resulting in more context switches
+//                                          than are strictly necessary.
+//
+//            multi_threaded_local        - Behaviour in this mode is essentially the same as multi_threaded_global,
+//                                          except that each signal, and each object that inherits has_slots, all
+//                                          have their own mutex/critical section. In practice, this means that
+//                                          mutex collisions (and hence context switches) only happen if they are
+//                                          absolutely essential. However, on some platforms, creating a lot of
+//                                          mutexes can slow down the whole OS, so use this option with care.
+//
+//            snapshot_emit<policy>       - Wraps one of the policies above. Connect and disconnect publish a new,
+//                                          immutable copy of the connection list, and emit calls the slots from
+//                                          a reference counted snapshot of it without holding any lock. Slow
+//                                          slots no longer stall other emitters, and slots may re-emit or
+//                                          disconnect the signal that called them. A slot disconnected on another
+//                                          thread may still be called by an emit that had already started.
+//
+//            multi_threaded_rw           - Like multi_threaded_local, but with a reader/writer lock: emit takes it
+//                                          shared and connect/disconnect exclusively, so any number of threads
+//                                          can emit the same signal at once. Slots must not connect to or
+//                                          disconnect from the signal calling them.
+//
+//            multi_threaded_spin         - Like multi_threaded_local, but a contended lock is spun on for a short
+//                                          while before the thread blocks. For locks held only for a very short
+//                                          time, such as signals with few, fast slots.
+//
+//            multi_threaded_striped<N>   - A middle way between multi_threaded_global and multi_threaded_local
+//                                          for programs with very many objects: each object locks one of N
+//                                          (64 by default) mutexes chosen by hashing its address, so objects
+//                                          need no mutex of their own and threads rarely contend. Where slots
+//                                          emit further signals, wrap it in snapshot_emit.
+//
+//            multi_threaded_lockfree     - For read-mostly signals. Connect and disconnect take a per-object mutex
+//                                          and publish a new connection array; emit takes no lock at all and only
+//                                          writes to memory owned by the emitting thread, so any number of cores
+//                                          can fire the same signal without contending. Replaced arrays are freed
+//                                          by epoch based reclamation once no emit can still be reading them.
+//
+//            instrumented<policy>        - Wraps any of the policies above to record, per signal, emit and slot call
+//                                          counts, log2 histograms of emit and slot times, the slowest slot and
+//                                          how long taking the lock waited. signal_registry::dump() prints every
+//                                          instrumented signal; set_name() labels one. Other signals pay nothing.
+//
+//            In every mode but multi_threaded_rw a slot may connect, disconnect or re-emit the signal calling it,
+//            or destroy its own receiver, with no recursive mutex needed. Where emit holds the signal's lock, a
+//            disconnect made during an emit only marks the connection, and connections made during an emit are
+//            held back until the outermost emit returns.
+//
+//            Teardown takes locks in one order in every mode: a signal locks its receivers while holding its own
+//            lock, never the other way round. A receiver being destroyed or disconnected only tries each signal's
+//            lock, and on failure lets go of its own until that signal is done, so any mix of signals and receivers
+//            may be destroyed concurrently. Under snapshot_emit and multi_threaded_lockfree it then waits for emits
+//            on other threads still calling its slots, but only after releasing its own lock, and without touching
+//            the signals again, which may be gone by then. has_slots disconnects only once the derived receiver's
+//            own members are gone, though: a receiver whose slots may be running on another thread should call
+//            disconnect() first thing in its destructor.
+//
+//        USING THE LIBRARY
+//
+//        See the full documentation at http://sigslot.sourceforge.net/
+//
+//        signal<arg_types...> is a signal taking any number of arguments under the default threading
+//        policy, and basic_signal<mt_policy, arg_types...> takes the policy explicitly. The classic
+//        signal0 .. signal8 names are aliases for these, so existing code keeps compiling. Arguments are
+//        passed to the slots by const reference unless they are small and trivially copyable; a slot may
+//        declare a parameter as const T& for a signal of T. Specialise param_traits to change this.
+//
+//        Besides member functions of has_slots receivers, connect() takes lambdas, function objects and free
+//        functions that are trivially copyable and no larger than two pointers. connect(&tracker, fn) ties
+//        such a connection to a sigslot::connection_tracker, typically a member of the object fn refers to,
+//        which disconnects it on destruction. Only types that need this tracking pay for it.
+//
+//        connect() returns a sigslot::connection. Its disconnect() removes just that connection, in constant
+//        time under the locked threading modes, where disconnect(&obj) has to search the signal's slots. The
+//        handle must not be used once the signal is gone; it may be ignored by code that does not need it.
+//        A sigslot::scoped_connection owns one and disconnects it when it goes out of scope.
+//
+//        For wiring or tearing down many connections at once, connect_many(first, last, &T::fn) connects fn of each
+//        receiver in a range of pointers, and disconnect_all_of(first, last) disconnects a range of receivers. Each
+//        takes the signal's lock once and grows, compacts or copies its connections once for the whole range.
+//        reserve(n) presizes a signal's connections, or a receiver's record of the signals it is connected to.
+//
+//        connect() takes an optional int priority as its last argument, 0 by default. Slots are called in
+//        order of descending priority, and in connection order within one priority, so a late subscriber on
+//        the critical path can still see each emit first. A slot that returns bool stops the emit by
+//        returning true: the slots after it are not called. emit_batch and emit_parallel call every slot.
+//
+//        keyed_signal<key_type, arg_types...> is for slots that each care about one value of the first argument,
+//        such as an instrument id. connect(key, &obj, &T::fn) subscribes a slot to one key, and emit(key, args...)
+//        finds that key's slots through a hash index and calls only those, instead of every slot of the signal.
+//
+//        result_signal<R (arg_types...), combiner> is a signal whose slots return R. emit returns what the combiner
+//        makes of their results, the last of them by default; combine_sum, combine_min, combine_max and
+//        combine_vector are provided, and any class with operator()(const R&) and result() will do.
+//
+//        coalescing_signal<arg_types...> keeps only the arguments of its latest emit, and calls its slots with them
+//        once per flush(), or through an event_queue at most once per time window, for signals that fire far more
+//        often than their slots need to run.
+//
+//        shm_bridge_writer<arg_types...> and shm_bridge_reader<arg_types...> carry a signal between processes through
+//        a ring buffer in named POSIX shared memory. The writer, attached to a local signal, copies each emit into the
+//        ring; the reader is itself a signal, which poll() emits once per message. Neither side makes a system call
+//        or takes a lock after setup. The arguments must be trivially copyable.
+//
+//        For wiring fixed at build time, basic_static_signal<static_slot<void (T::*)(), &T::fn>, ...>, or under C++17
+//        static_signal<&T::fn, ...>, binds each listed member function to an object given to its constructor. Its emit
+//        is a sequence of direct, inlinable calls, with no connection storage, lock or indirect call.
+//
+//        connect(&obj, &T::fn, sigslot::queued(queue)) makes a queued connection. emit copies the
+//        arguments into a message on the sigslot::event_queue, and the thread that owns the queue calls the
+//        slot when it next runs queue.process(). Use it to keep slot code on the receiver's own thread.
+//
+//        emit_batch(rows) emits once for each std::tuple<arg_types...> in a sigslot::span, under a single lock.
+//        A slot declared as void fn(sigslot::span<const std::tuple<arg_types...> >) can be connected to take
+//        each batch in one call.
+//
+//        set_trace_sink() installs a callback that sees the begin and end of every emit and slot call and every
+//        lock taken, for forwarding to a timeline tracer. With no sink installed each costs a single branch.
+//
+//        for_each_connection(visit, context) on a signal or a receiver calls visit with a connection_info for each
+//        of its connections, and heap_bytes() reports the memory either holds for them beyond its own size.
+//        Together with memory_totals() these size pool allocators and find receivers left holding connections.
+//
+//        emit_parallel(pool, args...) spreads the slots of one emit over the threads of a sigslot::thread_pool,
+//        for signals with many slots that are expensive and independent of each other. It always waits for every
+//        slot. Under the locked modes the emitting thread holds the signal's lock meanwhile, so these slots must
+//        not re-emit, connect to or disconnect from that signal, nor destroy a receiver connected to it; debug
+//        builds assert. Under snapshot_emit and multi_threaded_lockfree they may, as in any emit.
+//
+//
+
+#ifndef SIGSLOT_H__
+#define SIGSLOT_H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <vector>
+#include <type_traits>
+#include <utility>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#if defined(SIGSLOT_PURE_ISO) || (!defined(WIN32) && !defined(__GNUG__) && !defined(SIGSLOT_USE_POSIX_THREADS))
+#    define _SIGSLOT_SINGLE_THREADED
+#elif defined(WIN32)
+#    define _SIGSLOT_HAS_WIN32_THREADS
+#    include <windows.h>
+#elif defined(__GNUG__) || defined(SIGSLOT_USE_POSIX_THREADS)
+#    define _SIGSLOT_HAS_POSIX_THREADS
+#    include <pthread.h>
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#else
+#    define _SIGSLOT_SINGLE_THREADED
+#endif
+
+#ifndef SIGSLOT_ALLOCATOR
+#    define SIGSLOT_ALLOCATOR std::allocator
+#endif
+
+#ifdef SIGSLOT_STATIC_STORAGE
+#    ifndef SIGSLOT_MAX_SLOTS
+#        define SIGSLOT_MAX_SLOTS 8
+#    endif
+#    ifndef SIGSLOT_MAX_SENDERS
+#        define SIGSLOT_MAX_SENDERS 8
+#    endif
+#endif
+
+#ifndef SIGSLOT_DEFAULT_MT_POLICY
+#    ifdef _SIGSLOT_SINGLE_THREADED
+#        define SIGSLOT_DEFAULT_MT_POLICY single_threaded
+#    else
+#        define SIGSLOT_DEFAULT_MT_POLICY multi_threaded_local
+#    endif
+#endif
+
+
+namespace sigslot {
+
+    // The threading policies are template parameters, inherited by every signal and receiver and
+    // called statically: a policy needs lock(), unlock() and try_lock(), and lock_shared() and
+    // unlock_shared() for emit_shared, but nothing virtual. single_threaded is an empty base and
+    // costs neither space nor instructions.
+    class single_threaded
+    {
+    public:
+        single_threaded()
+        {
+        }
+
+        ~single_threaded()
+        {
+        }
+
+        void lock()
+        {
+        }
+
+        void unlock()
+        {
+        }
+
+        bool try_lock()
+        {
+            return true;
+        }
+    };
+
+#ifdef _SIGSLOT_HAS_WIN32_THREADS
+    // The mutex behind the policies that share locks between objects. Critical sections are
+    // recursive. There is deliberately no destructor: shared locks live in static storage and
+    // must outlast every object that could still lock them during static destruction.
+    class _recursive_mutex
+    {
+    public:
+        _recursive_mutex()
+        {
+            InitializeCriticalSection(&m_critsec);
+        }
+
+        void lock()
+        {
+            EnterCriticalSection(&m_critsec);
+        }
+
+        void unlock()
+        {
+            LeaveCriticalSection(&m_critsec);
+        }
+
+        bool try_lock()
+        {
+            return TryEnterCriticalSection(&m_critsec) != 0;
+        }
+
+    private:
+        CRITICAL_SECTION m_critsec;
+    };
+#endif // _SIGSLOT_HAS_WIN32_THREADS
+
+#ifdef _SIGSLOT_HAS_POSIX_THREADS
+    // The mutex behind the policies that share locks between objects. It is recursive because
+    // a thread holding a signal's lock goes on to lock the receivers, which may well map to
+    // the same mutex. There is deliberately no destructor: shared locks live in static storage
+    // and must outlast every object that could still lock them during static destruction.
+    class _recursive_mutex
+    {
+    public:
+        _recursive_mutex()
+        {
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+            pthread_mutex_init(&m_mutex, &attr);
+            pthread_mutexattr_destroy(&attr);
+        }
+
+        void lock()
+        {
+            pthread_mutex_lock(&m_mutex);
+        }
+
+        void unlock()
+        {
+            pthread_mutex_unlock(&m_mutex);
+        }
+
+        bool try_lock()
+        {
+            return pthread_mutex_trylock(&m_mutex) == 0;
+        }
+
+    private:
+        pthread_mutex_t m_mutex;
+    };
+#endif // _SIGSLOT_HAS_POSIX_THREADS
+
+#ifndef _SIGSLOT_SINGLE_THREADED
+    // The multi threading policies only get compiled in if they are enabled. The global mutex
+    // is created, once, on first use.
+    class multi_threaded_global
+    {
+    public:
+        void lock()
+        {
+            get_mutex().lock();
+        }
+
+        void unlock()
+        {
+            get_mutex().unlock();
+        }
+
+        bool try_lock()
+        {
+            return get_mutex().try_lock();
+        }
+
+    private:
+        static _recursive_mutex& get_mutex()
+        {
+            static _recursive_mutex g_mutex;
+            return g_mutex;
+        }
+    };
+
+    // Locks one of stripe_count mutexes, chosen by hashing the object's address, from a table
+    // shared by all objects using the policy. Objects carry no lock of their own, so millions
+    // of receivers cost no OS resources, yet threads only contend when their objects land on
+    // the same stripe. Receivers lock a second table, selected by _receiver_policy, so the
+    // signal-then-receiver nesting of connect and teardown cannot form a cycle between
+    // unrelated objects. Unrelated signals do share stripes, though: where slots emit other
+    // striped signals, use snapshot_emit<multi_threaded_striped<> >, whose emit calls the slots
+    // without holding the lock.
+    template<size_t stripe_count = 64, int table = 0>
+    class multi_threaded_striped
+    {
+    public:
+        void lock()
+        {
+            stripe().lock();
+        }
+
+        void unlock()
+        {
+            stripe().unlock();
+        }
+
+        bool try_lock()
+        {
+            return stripe().try_lock();
+        }
+
+    private:
+        static_assert(stripe_count != 0 && (stripe_count & (stripe_count - 1)) == 0,
+            "stripe_count must be a power of two");
+
+        struct alignas(64) padded_mutex
+        {
+            _recursive_mutex m_mutex;
+        };
+
+        _recursive_mutex& stripe() const
+        {
+            static padded_mutex stripes[stripe_count];
+            size_t h = reinterpret_cast<size_t>(static_cast<const void*>(this));
+            h *= static_cast<size_t>(0x9E3779B97F4A7C15ull);
+            return stripes[(h >> (sizeof(size_t) * 4)) & (stripe_count - 1)].m_mutex;
+        }
+    };
+#endif // _SIGSLOT_SINGLE_THREADED
+
+#ifdef _SIGSLOT_HAS_WIN32_THREADS
+
+    class multi_threaded_local
+    {
+    public:
+        multi_threaded_local()
+        {
+            InitializeCriticalSection(&m_critsec);
+        }
+
+        multi_threaded_local(const multi_threaded_local&)
+        {
+            InitializeCriticalSection(&m_critsec);
+        }
+
+        ~multi_threaded_local()
+        {
+            DeleteCriticalSection(&m_critsec);
+        }
+
+        void lock()
+        {
+            EnterCriticalSection(&m_critsec);
+        }
+
+        void unlock()
+        {
+            LeaveCriticalSection(&m_critsec);
+        }
+
+        bool try_lock()
+        {
+            return TryEnterCriticalSection(&m_critsec) != 0;
+        }
+
+    private:
+        CRITICAL_SECTION m_critsec;
+    };
+
+    class multi_threaded_rw
+    {
+    public:
+        multi_threaded_rw()
+        {
+            InitializeSRWLock(&m_lock);
+        }
+
+        multi_threaded_rw(const multi_threaded_rw&)
+        {
+            InitializeSRWLock(&m_lock);
+        }
+
+        ~multi_threaded_rw()
+        {
+        }
+
+        void lock()
+        {
+            AcquireSRWLockExclusive(&m_lock);
+        }
+
+        void unlock()
+        {
+            ReleaseSRWLockExclusive(&m_lock);
+        }
+
+        bool try_lock()
+        {
+            return TryAcquireSRWLockExclusive(&m_lock) != 0;
+        }
+
+        void lock_shared()
+        {
+            AcquireSRWLockShared(&m_lock);
+        }
+
+        void unlock_shared()
+        {
+            ReleaseSRWLockShared(&m_lock);
+        }
+
+    private:
+        SRWLOCK m_lock;
+    };
+
+    // A critical section spins for a while before it blocks, which is all this policy needs.
+    class multi_threaded_spin
+    {
+    public:
+        multi_threaded_spin()
+        {
+            InitializeCriticalSectionAndSpinCount(&m_critsec, 4000);
+        }
+
+        multi_threaded_spin(const multi_threaded_spin&)
+        {
+            InitializeCriticalSectionAndSpinCount(&m_critsec, 4000);
+        }
+
+        ~multi_threaded_spin()
+        {
+            DeleteCriticalSection(&m_critsec);
+        }
+
+        void lock()
+        {
+            EnterCriticalSection(&m_critsec);
+        }
+
+        void unlock()
+        {
+            LeaveCriticalSection(&m_critsec);
+        }
+
+        bool try_lock()
+        {
+            return TryEnterCriticalSection(&m_critsec) != 0;
+        }
+
+    private:
+        CRITICAL_SECTION m_critsec;
+    };
+#endif // _SIGSLOT_HAS_WIN32_THREADS
+
+#ifdef _SIGSLOT_HAS_POSIX_THREADS
+    class multi_threaded_local
+    {
+    public:
+        multi_threaded_local()
+        {
+            pthread_mutex_init(&m_mutex, NULL);
+        }
+
+        multi_threaded_local(const multi_threaded_local&)
+        {
+            pthread_mutex_init(&m_mutex, NULL);
+        }
+
+        ~multi_threaded_local()
+        {
+            pthread_mutex_destroy(&m_mutex);
+        }
+
+        void lock()
+        {
+            pthread_mutex_lock(&m_mutex);
+        }
+
+        void unlock()
+        {
+            pthread_mutex_unlock(&m_mutex);
+        }
+
+        bool try_lock()
+        {
+            return pthread_mutex_trylock(&m_mutex) == 0;
+        }
+
+    private:
+        pthread_mutex_t m_mutex;
+    };
+
+    class multi_threaded_rw
+    {
+    public:
+        multi_threaded_rw()
+        {
+            pthread_rwlock_init(&m_lock, NULL);
+        }
+
+        multi_threaded_rw(const multi_threaded_rw&)
+        {
+            pthread_rwlock_init(&m_lock, NULL);
+        }
+
+        ~multi_threaded_rw()
+        {
+            pthread_rwlock_destroy(&m_lock);
+        }
+
+        void lock()
+        {
+            pthread_rwlock_wrlock(&m_lock);
+        }
+
+        void unlock()
+        {
+            pthread_rwlock_unlock(&m_lock);
+        }
+
+        bool try_lock()
+        {
+            return pthread_rwlock_trywrlock(&m_lock) == 0;
+        }
+
+        void lock_shared()
+        {
+            pthread_rwlock_rdlock(&m_lock);
+        }
+
+        void unlock_shared()
+        {
+            pthread_rwlock_unlock(&m_lock);
+        }
+
+    private:
+        pthread_rwlock_t m_lock;
+    };
+
+    // Tries the mutex a bounded number of times, backing off between attempts, and only then
+    // blocks on it, so a critical section a few instructions long is waited out on the CPU
+    // rather than with a trip through the scheduler.
+    class multi_threaded_spin
+    {
+    public:
+        multi_threaded_spin()
+        {
+            pthread_mutex_init(&m_mutex, NULL);
+        }
+
+        multi_threaded_spin(const multi_threaded_spin&)
+        {
+            pthread_mutex_init(&m_mutex, NULL);
+        }
+
+        ~multi_threaded_spin()
+        {
+            pthread_mutex_destroy(&m_mutex);
+        }
+
+        void lock()
+        {
+            for(unsigned backoff = 1; backoff <= 256; backoff *= 2)
+            {
+                if(pthread_mutex_trylock(&m_mutex) == 0)
+                    return;
+
+                for(unsigned i = 0; i < backoff; ++i)
+                    cpu_relax();
+            }
+
+            pthread_mutex_lock(&m_mutex);
+        }
+
+        void unlock()
+        {
+            pthread_mutex_unlock(&m_mutex);
+        }
+
+        bool try_lock()
+        {
+            return pthread_mutex_trylock(&m_mutex) == 0;
+        }
+
+    private:
+        static void cpu_relax()
+        {
+#if defined(__i386__) || defined(__x86_64__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+            __asm__ __volatile__("yield");
+#endif
+        }
+
+        pthread_mutex_t m_mutex;
+    };
+#endif // _SIGSLOT_HAS_POSIX_THREADS
+
+    // Emit models. By default a signal holds its policy lock while it calls its slots
+    // (emit_locked). A policy can ask for a different model by specialising _emit_model.
+    struct emit_locked
+    {
+    };
+
+    struct emit_snapshot
+    {
+    };
+
+    struct emit_lockfree
+    {
+    };
+
+    struct emit_shared
+    {
+    };
+
+    template<class mt_policy>
+    struct _emit_model
+    {
+        typedef emit_locked type;
+    };
+
+    // Wraps any of the threading policies above. Signals using it publish a new, immutable
+    // connection list on every connect and disconnect, and emit walks a reference counted
+    // snapshot of that list without holding the lock, so slow slots never block other emitters
+    // or connect/disconnect, and a slot may safely re-emit the signal that called it.
+    template<class mt_policy>
+    class snapshot_emit : public mt_policy
+    {
+    };
+
+    template<class mt_policy>
+    struct _emit_model<snapshot_emit<mt_policy> >
+    {
+        typedef emit_snapshot type;
+    };
+
+    // The policy has_slots<mt_policy> locks with: mt_policy itself, bar the emit model, except
+    // that striped policies give receivers a table separate from their signals'.
+    template<class mt_policy>
+    struct _receiver_policy
+    {
+        typedef mt_policy type;
+    };
+
+    template<class mt_policy>
+    struct _receiver_policy<snapshot_emit<mt_policy> >
+    {
+        typedef typename _receiver_policy<mt_policy>::type type;
+    };
+
+#ifndef _SIGSLOT_SINGLE_THREADED
+    // Uses a mutex per object for connect and disconnect only. Signals store their connections
+    // in an atomically swapped array, and emit reads it inside an epoch critical section
+    // (see _epoch_domain) without taking any lock, so emit never blocks and never writes to
+    // memory shared with other emitting threads. Replaced arrays are freed once every emit that
+    // could still be reading them has finished.
+    class multi_threaded_lockfree : public multi_threaded_local
+    {
+    };
+
+    template<>
+    struct _emit_model<multi_threaded_lockfree>
+    {
+        typedef emit_lockfree type;
+    };
+
+    // Emits under the shared side of the lock, so emitters only exclude connect and disconnect.
+    template<>
+    struct _emit_model<multi_threaded_rw>
+    {
+        typedef emit_shared type;
+    };
+
+    template<size_t stripe_count>
+    struct _receiver_policy<multi_threaded_striped<stripe_count, 0> >
+    {
+        typedef multi_threaded_striped<stripe_count, 1> type;
+    };
+#endif // _SIGSLOT_SINGLE_THREADED
+
+    // What a trace_sink is told. On the thread concerned, emit and slot events come in
+    // begin/end pairs, lock_wait is followed by lock_acquired once the lock is taken, and
+    // lock_released follows when it is let go.
+    enum trace_event
+    {
+        trace_emit_begin,
+        trace_emit_end,
+        trace_slot_begin,
+        trace_slot_end,
+        trace_lock_wait,
+        trace_lock_acquired,
+        trace_lock_released
+    };
+
+    struct trace_record
+    {
+        trace_event m_event;
+        // The signal for emit events, the slot's receiver for slot events (NULL for a function
+        // object connected without a tracker) and the lock for lock events.
+        const void* m_object;
+        // The name given to an instrumented<> signal, or NULL.
+        const char* m_signal_name;
+        // For slot events, the type of the slot as the compiler spells it.
+        const char* m_slot_type;
+    };
+
+    // Receives trace events once installed with set_trace_sink(), to forward them to Perfetto,
+    // ETW, LTTng or the like. The function is called inside emits and with locks held, so it
+    // must be quick and must not use signals itself.
+    struct trace_sink
+    {
+        void (*m_function)(void* context, const trace_record& record);
+        void* m_context;
+
+        void trace(trace_event event, const void* object, const char* signal_name = NULL,
+            const char* slot_type = NULL) const
+        {
+            trace_record record = { event, object, signal_name, slot_type };
+            m_function(m_context, record);
+        }
+    };
+
+    inline std::atomic<const trace_sink*>& _trace_sink_slot()
+    {
+        static std::atomic<const trace_sink*> sink(NULL);
+        return sink;
+    }
+
+    inline const trace_sink* _trace_sink()
+    {
+        return _trace_sink_slot().load(std::memory_order_acquire);
+    }
+
+    // Installs sink, or turns tracing off if it is NULL. Emits already running keep reporting to
+    // the sink they started with, so a sink must outlive them. With no sink installed, each emit,
+    // slot call and lock costs one branch.
+    inline void set_trace_sink(const trace_sink* sink)
+    {
+        _trace_sink_slot().store(sink, std::memory_order_release);
+    }
+
+    // Policies built on single_threaded have nothing to wait for, and report no lock events.
+    template<class mt_policy>
+    struct _traces_locks
+        : std::integral_constant<bool, !std::is_base_of<single_threaded, mt_policy>::value>
+    {
+    };
+
+    template<class mt_policy>
+    inline void _lock_traced(mt_policy* mtx)
+    {
+        const trace_sink* sink = _traces_locks<mt_policy>::value ? _trace_sink() : NULL;
+
+        if(sink != NULL)
+            sink->trace(trace_lock_wait, mtx);
+
+        mtx->lock();
+
+        if(sink != NULL)
+            sink->trace(trace_lock_acquired, mtx);
+    }
+
+    template<class mt_policy>
+    inline void _unlock_traced(mt_policy* mtx)
+    {
+        mtx->unlock();
+
+        const trace_sink* sink = _traces_locks<mt_policy>::value ? _trace_sink() : NULL;
+
+        if(sink != NULL)
+            sink->trace(trace_lock_released, mtx);
+    }
+
+    template<class mt_policy>
+    class lock_block
+    {
+    public:
+        mt_policy *m_mutex;
+
+        lock_block(mt_policy *mtx)
+            : m_mutex(mtx)
+        {
+            _lock_traced(m_mutex);
+        }
+
+        ~lock_block()
+        {
+            _unlock_traced(m_mutex);
+        }
+    };
+
+    template<class mt_policy>
+    class lock_block_shared
+    {
+    public:
+        mt_policy *m_mutex;
+
+        lock_block_shared(mt_policy *mtx)
+            : m_mutex(mtx)
+        {
+            const trace_sink* sink = _traces_locks<mt_policy>::value ? _trace_sink() : NULL;
+
+            if(sink != NULL)
+                sink->trace(trace_lock_wait, m_mutex);
+
+            m_mutex->lock_shared();
+
+            if(sink != NULL)
+                sink->trace(trace_lock_acquired, m_mutex);
+        }
+
+        ~lock_block_shared()
+        {
+            m_mutex->unlock_shared();
+
+            const trace_sink* sink = _traces_locks<mt_policy>::value ? _trace_sink() : NULL;
+
+            if(sink != NULL)
+                sink->trace(trace_lock_released, m_mutex);
+        }
+    };
+
+#ifdef _SIGSLOT_SINGLE_THREADED
+    typedef single_threaded _sigslot_internal_lock;
+#else
+    typedef multi_threaded_local _sigslot_internal_lock;
+#endif
+
+    // What an instrumented<> signal has recorded so far. Times are in nanoseconds. Histogram
+    // bucket b counts the times from 2^b up to 2^(b+1) ns, with anything shorter in bucket 0.
+    // The counters are updated without locking, so a reading taken while the signal is in use
+    // may be slightly inconsistent.
+    struct signal_stats
+    {
+        enum
+        {
+            buckets = 40
+        };
+
+        signal_stats()
+            : m_emits(0), m_slot_calls(0), m_slots(0), m_emit_ns(0), m_lock_waits(0),
+            m_lock_wait_ns(0), m_slowest_ns(0), m_slowest_receiver(NULL), m_slowest_position(0)
+        {
+            for(size_t b = 0; b < buckets; ++b)
+            {
+                m_emit_histogram[b] = 0;
+                m_slot_histogram[b] = 0;
+            }
+        }
+
+        static size_t bucket(unsigned long long ns)
+        {
+            size_t b = 0;
+
+            while(ns > 1 && b < buckets - 1)
+            {
+                ns >>= 1;
+                ++b;
+            }
+
+            return b;
+        }
+
+        void record_emit(unsigned long long ns, size_t slots)
+        {
+            m_emits.fetch_add(1, std::memory_order_relaxed);
+            m_slots.store(slots, std::memory_order_relaxed);
+            m_emit_ns.fetch_add(ns, std::memory_order_relaxed);
+            m_emit_histogram[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // receiver is the slot's object, or NULL for a function object.
+        void record_slot(unsigned long long ns, const void* receiver, size_t position)
+        {
+            m_slot_calls.fetch_add(1, std::memory_order_relaxed);
+            m_slot_histogram[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+
+            unsigned long long slowest = m_slowest_ns.load(std::memory_order_relaxed);
+
+            while(ns > slowest)
+            {
+                if(m_slowest_ns.compare_exchange_weak(slowest, ns, std::memory_order_relaxed))
+                {
+                    m_slowest_receiver.store(receiver, std::memory_order_relaxed);
+                    m_slowest_position.store(position, std::memory_order_relaxed);
+                    break;
+                }
+            }
+        }
+
+        void record_lock_wait(unsigned long long ns)
+        {
+            m_lock_waits.fetch_add(1, std::memory_order_relaxed);
+            m_lock_wait_ns.fetch_add(ns, std::memory_order_relaxed);
+        }
+
+        std::atomic<unsigned long long> m_emits;
+        std::atomic<unsigned long long> m_slot_calls;
+        // Slots seen by the latest emit.
+        std::atomic<size_t> m_slots;
+        std::atomic<unsigned long long> m_emit_ns;
+        // Locks that were taken and had to be waited for.
+        std::atomic<unsigned long long> m_lock_waits;
+        std::atomic<unsigned long long> m_lock_wait_ns;
+        // The slowest single slot call so far, and where that slot was in the signal.
+        std::atomic<unsigned long long> m_slowest_ns;
+        std::atomic<const void*> m_slowest_receiver;
+        std::atomic<size_t> m_slowest_position;
+        std::atomic<unsigned long long> m_emit_histogram[buckets];
+        std::atomic<unsigned long long> m_slot_histogram[buckets];
+    };
+
+    inline unsigned long long _elapsed_ns(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - since).count();
+    }
+
+    // The part of instrumented<> that does not depend on the policy: the signal's stats, its
+    // name and its place in the list signal_registry walks.
+    class _instrumented_signal
+    {
+    public:
+        _instrumented_signal()
+            : m_name(NULL)
+        {
+            link();
+        }
+
+        _instrumented_signal(const _instrumented_signal& other)
+            : m_name(other.m_name)
+        {
+            link();
+        }
+
+        ~_instrumented_signal()
+        {
+            registry& list = get_registry();
+            lock_block<_sigslot_internal_lock> lock(&list.m_lock);
+            *m_pprev = m_next;
+
+            if(m_next != NULL)
+                m_next->m_pprev = m_pprev;
+        }
+
+        // Shown by signal_registry::dump. The string is not copied.
+        void set_name(const char* name)
+        {
+            m_name = name;
+        }
+
+        const char* name() const
+        {
+            return m_name;
+        }
+
+        signal_stats& stats()
+        {
+            return m_stats;
+        }
+
+        const signal_stats& stats() const
+        {
+            return m_stats;
+        }
+
+    private:
+        friend class signal_registry;
+
+        _instrumented_signal& operator=(const _instrumented_signal&);
+
+        struct registry
+        {
+            registry()
+                : m_head(NULL)
+            {
+            }
+
+            _sigslot_internal_lock m_lock;
+            _instrumented_signal* m_head;
+        };
+
+        static registry& get_registry()
+        {
+            static registry list;
+            return list;
+        }
+
+        void link()
+        {
+            registry& list = get_registry();
+            lock_block<_sigslot_internal_lock> lock(&list.m_lock);
+            m_next = list.m_head;
+            m_pprev = &list.m_head;
+
+            if(m_next != NULL)
+                m_next->m_pprev = &m_next;
+
+            list.m_head = this;
+        }
+
+        signal_stats m_stats;
+        const char* m_name;
+        _instrumented_signal* m_next;
+        _instrumented_signal** m_pprev;
+    };
+
+    // Wraps any of the threading policies to record, for each signal using it, how often it is
+    // emitted, how long emits and single slot calls take, the slowest slot seen and how long
+    // taking the signal's lock had to wait. Signals of other policies pay nothing; receivers
+    // of an instrumented signal lock as the wrapped policy does and are not counted.
+    template<class mt_policy>
+    class instrumented : public mt_policy, public _instrumented_signal
+    {
+    public:
+        void lock()
+        {
+            if(mt_policy::try_lock())
+                return;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            mt_policy::lock();
+            stats().record_lock_wait(_elapsed_ns(start));
+        }
+
+        // There is no try_lock_shared, so every shared lock is timed, and those that took under
+        // a microsecond are not counted as waits.
+        void lock_shared()
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            mt_policy::lock_shared();
+            unsigned long long ns = _elapsed_ns(start);
+
+            if(ns >= 1000)
+                stats().record_lock_wait(ns);
+        }
+    };
+
+    template<class mt_policy>
+    struct _emit_model<instrumented<mt_policy> >
+    {
+        typedef typename _emit_model<mt_policy>::type type;
+    };
+
+    template<class mt_policy>
+    struct _receiver_policy<instrumented<mt_policy> >
+    {
+        typedef typename _receiver_policy<mt_policy>::type type;
+    };
+
+    // Every instrumented<> signal currently alive.
+    class signal_registry
+    {
+    public:
+        typedef void (*visit_function)(void* context, const _instrumented_signal& signal);
+
+        // Runs under the registry lock, so visit must not create or destroy instrumented signals.
+        static void for_each(visit_function visit, void* context)
+        {
+            _instrumented_signal::registry& list = _instrumented_signal::get_registry();
+            lock_block<_sigslot_internal_lock> lock(&list.m_lock);
+
+            for(const _instrumented_signal* signal = list.m_head; signal != NULL;
+                signal = signal->m_next)
+            {
+                visit(context, *signal);
+            }
+        }
+
+        // Writes one line per signal, followed by a line per non-empty histogram listing each
+        // non-empty bucket as lower_bound_ns:count. Unnamed signals are shown by address.
+        static void dump(FILE* out = stderr)
+        {
+            for_each(&dump_signal, out);
+        }
+
+    private:
+        static void dump_signal(void* context, const _instrumented_signal& signal)
+        {
+            FILE* out = static_cast<FILE*>(context);
+            const signal_stats& stats = signal.stats();
+
+            if(signal.name() != NULL)
+                fprintf(out, "signal %s", signal.name());
+            else
+                fprintf(out, "signal %p", static_cast<const void*>(&signal));
+
+            fprintf(out, " emits=%llu slots=%lu slot_calls=%llu emit_ns=%llu lock_waits=%llu"
+                " lock_wait_ns=%llu slowest_ns=%llu slowest_receiver=%p slowest_position=%lu\n",
+                stats.m_emits.load(), (unsigned long)stats.m_slots.load(),
+                stats.m_slot_calls.load(), stats.m_emit_ns.load(), stats.m_lock_waits.load(),
+                stats.m_lock_wait_ns.load(), stats.m_slowest_ns.load(),
+                stats.m_slowest_receiver.load(), (unsigned long)stats.m_slowest_position.load());
+            dump_histogram(out, "emit_ns", stats.m_emit_histogram);
+            dump_histogram(out, "slot_ns", stats.m_slot_histogram);
+        }
+
+        static void dump_histogram(FILE* out, const char* label,
+            const std::atomic<unsigned long long> (&histogram)[signal_stats::buckets])
+        {
+            bool empty = true;
+
+            for(size_t b = 0; b < signal_stats::buckets; ++b)
+            {
+                unsigned long long count = histogram[b].load();
+
+                if(count == 0)
+                    continue;
+
+                if(empty)
+                    fprintf(out, "    %s", label);
+
+                fprintf(out, " %llu:%llu", b == 0 ? 0ULL : 1ULL << b, count);
+                empty = false;
+            }
+
+            if(!empty)
+                fprintf(out, "\n");
+        }
+    };
+
+    // Times an emit and each slot call for instrumented<> signals. For any other policy every
+    // member is empty and the probe compiles to nothing.
+    template<class mt_policy,
+    bool is_instrumented = std::is_base_of<_instrumented_signal, mt_policy>::value>
+    class _emit_probe
+    {
+    public:
+        _emit_probe(mt_policy*, size_t)
+        {
+        }
+
+        template<class slot_type>
+        void called(const slot_type&, size_t)
+        {
+        }
+    };
+
+    template<class mt_policy>
+    class _emit_probe<mt_policy, true>
+    {
+    public:
+        _emit_probe(mt_policy* signal, size_t slots)
+            : m_stats(static_cast<_instrumented_signal*>(signal)->stats()), m_slots(slots),
+            m_start(std::chrono::steady_clock::now()), m_mark(m_start)
+        {
+        }
+
+        ~_emit_probe()
+        {
+            m_stats.record_emit(_elapsed_ns(m_start), m_slots);
+        }
+
+        // Charges the time since the previous call, or since the emit started, to slot.
+        template<class slot_type>
+        void called(const slot_type& slot, size_t position)
+        {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            m_stats.record_slot(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                now - m_mark).count(), slot->receiver(), position);
+            m_mark = now;
+        }
+
+    private:
+        signal_stats& m_stats;
+        size_t m_slots;
+        std::chrono::steady_clock::time_point m_start;
+        std::chrono::steady_clock::time_point m_mark;
+    };
+
+    inline const char* _signal_name(const _instrumented_signal* signal)
+    {
+        return signal->name();
+    }
+
+    inline const char* _signal_name(const void*)
+    {
+        return NULL;
+    }
+
+    // Reports one emit and its slot calls to the trace sink. The sink is read once per emit, so
+    // with tracing off each slot costs a branch on a value already in a register.
+    template<class signal_type>
+    class _emit_trace
+    {
+    public:
+        _emit_trace(const signal_type* signal)
+            : m_sink(_trace_sink()), m_signal(signal), m_name(NULL)
+        {
+            if(m_sink != NULL)
+            {
+                m_name = _signal_name(signal);
+                m_sink->trace(trace_emit_begin, m_signal, m_name);
+            }
+        }
+
+        ~_emit_trace()
+        {
+            if(m_sink != NULL)
+                m_sink->trace(trace_emit_end, m_signal, m_name);
+        }
+
+        template<class slot_type>
+        void slot_begin(const slot_type& slot) const
+        {
+            if(m_sink != NULL)
+                m_sink->trace(trace_slot_begin, slot->receiver(), m_name, slot->m_slot_type);
+        }
+
+        template<class slot_type>
+        void slot_end(const slot_type& slot) const
+        {
+            if(m_sink != NULL)
+                m_sink->trace(trace_slot_end, slot->receiver(), m_name, slot->m_slot_type);
+        }
+
+    private:
+        const trace_sink* m_sink;
+        const signal_type* m_signal;
+        const char* m_name;
+    };
+
+    // Process wide totals, kept only when SIGSLOT_MEMORY_STATS is defined; otherwise every
+    // counter stays 0 and counting compiles to nothing. Allocated bytes are what the library
+    // currently holds from SIGSLOT_ALLOCATOR: connection arrays, snapshots, sender sets, keyed
+    // signal indexes and queued messages. Pool bytes are the slabs _slab_pool has taken from
+    // the system for pool_allocator, which it never gives back.
+    struct memory_stats
+    {
+        memory_stats()
+            : m_connections(0), m_peak_connections(0), m_allocated_bytes(0),
+            m_peak_allocated_bytes(0), m_pool_bytes(0)
+        {
+        }
+
+        static void add(std::atomic<size_t>& value, std::atomic<size_t>& peak, size_t n)
+        {
+            size_t now = value.fetch_add(n, std::memory_order_relaxed) + n;
+            size_t highest = peak.load(std::memory_order_relaxed);
+
+            while(now > highest &&
+                !peak.compare_exchange_weak(highest, now, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        // One line, for logging alongside signal_registry::dump.
+        void dump(FILE* out = stderr) const
+        {
+            fprintf(out, "sigslot connections=%lu peak_connections=%lu allocated_bytes=%lu"
+                " peak_allocated_bytes=%lu pool_bytes=%lu\n",
+                (unsigned long)m_connections.load(), (unsigned long)m_peak_connections.load(),
+                (unsigned long)m_allocated_bytes.load(),
+                (unsigned long)m_peak_allocated_bytes.load(), (unsigned long)m_pool_bytes.load());
+        }
+
+        // Connections currently made, over every signal and threading policy.
+        std::atomic<size_t> m_connections;
+        std::atomic<size_t> m_peak_connections;
+        std::atomic<size_t> m_allocated_bytes;
+        std::atomic<size_t> m_peak_allocated_bytes;
+        std::atomic<size_t> m_pool_bytes;
+    };
+
+    // Trivially destructible, so still usable by signals destroyed during static destruction.
+    inline memory_stats& _memory_stats()
+    {
+        static memory_stats totals;
+        return totals;
+    }
+
+    inline const memory_stats& memory_totals()
+    {
+        return _memory_stats();
+    }
+
+    inline void _count_connection(bool connected)
+    {
+#ifdef SIGSLOT_MEMORY_STATS
+        memory_stats& totals = _memory_stats();
+
+        if(connected)
+            memory_stats::add(totals.m_connections, totals.m_peak_connections, 1);
+        else
+            totals.m_connections.fetch_sub(1, std::memory_order_relaxed);
+#else
+        (void)connected;
+#endif
+    }
+
+    inline void _count_allocation(size_t bytes, bool allocated)
+    {
+#ifdef SIGSLOT_MEMORY_STATS
+        memory_stats& totals = _memory_stats();
+
+        if(allocated)
+            memory_stats::add(totals.m_allocated_bytes, totals.m_peak_allocated_bytes, bytes);
+        else
+            totals.m_allocated_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+#else
+        (void)bytes;
+        (void)allocated;
+#endif
+    }
+
+    // Per-thread slab pool behind pool_allocator. Requests of up to max_block bytes are served
+    // from size classes carved out of 64 KB slabs; anything larger goes to operator new. A block
+    // may be freed on any thread and joins that thread's free list. Slabs are never returned to
+    // the system: a free list that grows past two slabs' worth, or belongs to a thread that
+    // exits, is handed to a shared orphan list, which threads whose own list has run dry draw
+    // from before they allocate a new slab. Blocks freed by a consumer thread thus find their
+    // way back to the thread producing them.
+    class _slab_pool
+    {
+    public:
+        enum
+        {
+            granularity = 16,
+            max_block = 256,
+            classes = max_block / granularity,
+            slab_size = 65536
+        };
+
+        static void* allocate(size_t bytes)
+        {
+            if(bytes > max_block)
+                return ::operator new(bytes);
+
+            size_t cls = size_class(bytes);
+            cache& local = local_cache();
+            block* b = local.m_exited ? NULL : local.m_free[cls];
+
+            if(b == NULL)
+            {
+                b = refill(cls, local);
+            }
+            else
+            {
+                local.m_free[cls] = b->m_next;
+                --local.m_count[cls];
+            }
+
+            return b;
+        }
+
+        static void deallocate(void* p, size_t bytes)
+        {
+            if(bytes > max_block)
+            {
+                ::operator delete(p);
+                return;
+            }
+
+            size_t cls = size_class(bytes);
+            cache& local = local_cache();
+            block* b = static_cast<block*>(p);
+
+            if(local.m_exited)
+            {
+                orphans& shared = shared_orphans();
+                lock_block<_sigslot_internal_lock> lock(&shared.m_lock);
+                b->m_next = shared.m_free[cls];
+                shared.m_free[cls] = b;
+                return;
+            }
+
+            b->m_next = local.m_free[cls];
+            local.m_free[cls] = b;
+
+            if(++local.m_count[cls] >= 2 * (slab_size / ((cls + 1) * granularity)))
+                release(cls, local);
+        }
+
+    private:
+        struct block
+        {
+            block* m_next;
+        };
+
+        // Trivially destructible, so that signals destroyed during static destruction, after
+        // the thread's exit_guard has run, can still free into the pool.
+        struct cache
+        {
+            block* m_free[classes];
+            size_t m_count[classes];
+            bool m_exited;
+        };
+
+        struct orphans
+        {
+            block* m_free[classes];
+            _sigslot_internal_lock m_lock;
+        };
+
+        class exit_guard
+        {
+        public:
+            exit_guard()
+            {
+                shared_orphans();
+            }
+
+            ~exit_guard()
+            {
+                cache& local = local_cache_storage();
+
+                for(size_t cls = 0; cls < classes; ++cls)
+                    release(cls, local);
+
+                local.m_exited = true;
+            }
+        };
+
+        static size_t size_class(size_t bytes)
+        {
+            return bytes == 0 ? 0 : (bytes - 1) / granularity;
+        }
+
+        static cache& local_cache_storage()
+        {
+            static thread_local cache local;
+            return local;
+        }
+
+        static cache& local_cache()
+        {
+            cache& local = local_cache_storage();
+
+            if(!local.m_exited)
+            {
+                static thread_local exit_guard guard;
+                (void)guard;
+            }
+
+            return local;
+        }
+
+        // Deliberately never destroyed: blocks may be freed into it during static destruction.
+        static orphans& shared_orphans()
+        {
+            static orphans* shared = new orphans();
+            return *shared;
+        }
+
+        // Hands the thread's whole free list for cls to the orphan list.
+        static void release(size_t cls, cache& local)
+        {
+            block* list = local.m_free[cls];
+
+            if(list == NULL)
+                return;
+
+            block* tail = list;
+
+            while(tail->m_next != NULL)
+                tail = tail->m_next;
+
+            orphans& shared = shared_orphans();
+            lock_block<_sigslot_internal_lock> lock(&shared.m_lock);
+            tail->m_next = shared.m_free[cls];
+            shared.m_free[cls] = list;
+            local.m_free[cls] = NULL;
+            local.m_count[cls] = 0;
+        }
+
+        static block* carve(size_t cls, block*& tail)
+        {
+            size_t size = (cls + 1) * granularity;
+            char* slab = static_cast<char*>(::operator new(slab_size));
+#ifdef SIGSLOT_MEMORY_STATS
+            _memory_stats().m_pool_bytes.fetch_add(slab_size, std::memory_order_relaxed);
+#endif
+            block* head = reinterpret_cast<block*>(slab);
+            tail = head;
+
+            for(size_t offset = size; offset + size <= slab_size; offset += size)
+            {
+                tail->m_next = reinterpret_cast<block*>(slab + offset);
+                tail = tail->m_next;
+            }
+
+            tail->m_next = NULL;
+            return head;
+        }
+
+        static size_t length(const block* list)
+        {
+            size_t n = 0;
+
+            for(; list != NULL; list = list->m_next)
+                ++n;
+
+            return n;
+        }
+
+        // Returns one block and keeps the rest of the list it came from: in the thread's own
+        // cache normally, or in the orphan list once the thread is exiting.
+        static block* refill(size_t cls, cache& local)
+        {
+            orphans& shared = shared_orphans();
+
+            {
+                lock_block<_sigslot_internal_lock> lock(&shared.m_lock);
+                block* list = shared.m_free[cls];
+
+                if(list != NULL)
+                {
+                    if(local.m_exited)
+                    {
+                        shared.m_free[cls] = list->m_next;
+                    }
+                    else
+                    {
+                        shared.m_free[cls] = NULL;
+                        local.m_free[cls] = list->m_next;
+                        local.m_count[cls] = length(list->m_next);
+                    }
+
+                    return list;
+                }
+            }
+
+            block* tail;
+            block* list = carve(cls, tail);
+
+            if(local.m_exited)
+            {
+                lock_block<_sigslot_internal_lock> lock(&shared.m_lock);
+                tail->m_next = shared.m_free[cls];
+                shared.m_free[cls] = list->m_next;
+            }
+            else
+            {
+                local.m_free[cls] = list->m_next;
+                local.m_count[cls] = slab_size / ((cls + 1) * granularity) - 1;
+            }
+
+            return list;
+        }
+    };
+
+    // A stateless allocator drawing from _slab_pool. #define SIGSLOT_ALLOCATOR as
+    // sigslot::pool_allocator to use it for all of the library's internal storage.
+    template<class T>
+    class pool_allocator
+    {
+    public:
+        typedef T value_type;
+
+        template<class U>
+        struct rebind
+        {
+            typedef pool_allocator<U> other;
+        };
+
+        pool_allocator()
+        {
+        }
+
+        template<class U>
+        pool_allocator(const pool_allocator<U>&)
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            if(std::alignment_of<T>::value > _slab_pool::granularity)
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+
+            return static_cast<T*>(_slab_pool::allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            if(std::alignment_of<T>::value > _slab_pool::granularity)
+                ::operator delete(p);
+            else
+                _slab_pool::deallocate(p, n * sizeof(T));
+        }
+    };
+
+    template<class T, class U>
+    bool operator==(const pool_allocator<T>&, const pool_allocator<U>&)
+    {
+        return true;
+    }
+
+    template<class T, class U>
+    bool operator!=(const pool_allocator<T>&, const pool_allocator<U>&)
+    {
+        return false;
+    }
+
+    // What the library allocates its internal storage with: SIGSLOT_ALLOCATOR, which like
+    // pool_allocator must be stateless, counted in memory_totals() under SIGSLOT_MEMORY_STATS.
+    template<class T>
+    class _allocator
+    {
+    public:
+        typedef T value_type;
+
+        template<class U>
+        struct rebind
+        {
+            typedef _allocator<U> other;
+        };
+
+        _allocator()
+        {
+        }
+
+        template<class U>
+        _allocator(const _allocator<U>&)
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            T* p = SIGSLOT_ALLOCATOR<T>().allocate(n);
+            _count_allocation(n * sizeof(T), true);
+            return p;
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            _count_allocation(n * sizeof(T), false);
+            SIGSLOT_ALLOCATOR<T>().deallocate(p, n);
+        }
+    };
+
+    template<class T, class U>
+    bool operator==(const _allocator<T>&, const _allocator<U>&)
+    {
+        return true;
+    }
+
+    template<class T, class U>
+    bool operator!=(const _allocator<T>&, const _allocator<U>&)
+    {
+        return false;
+    }
+
+    // Base for the library's internal heap objects, so that new and delete on them go through
+    // SIGSLOT_ALLOCATOR as well.
+    class _allocated_object
+    {
+    public:
+        static void* operator new(size_t size)
+        {
+            return _allocator<char>().allocate(size);
+        }
+
+        static void operator delete(void* p, size_t size)
+        {
+            _allocator<char>().deallocate(static_cast<char*>(p), size);
+        }
+    };
+
+    // How far an emit_snapshot signal's old snapshots have been freed, kept outside the signal.
+    // A receiver waiting on it holds a reference, so it stays readable once the signal is gone.
+    class _reclaim_counter : public _allocated_object
+    {
+    public:
+        _reclaim_counter()
+            : m_generation(0), m_refs(1)
+        {
+        }
+
+        void add_ref()
+        {
+            m_refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release()
+        {
+            if(m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete this;
+        }
+
+        std::atomic<unsigned long> m_generation;
+
+    private:
+        std::atomic<long> m_refs;
+    };
+
+    // What a receiver's disconnect still has to wait for once it has let go of its own lock:
+    // emits on other threads that may be calling its slots through the connections it removed.
+    // A slot of such an emit may need the receiver's lock, so try_disconnect only records the
+    // wait here, and wait() runs after the lock is released.
+    class _reclaim_wait
+    {
+    public:
+        typedef void (*synchronize_type)(unsigned long epoch);
+
+        _reclaim_wait()
+            : m_synchronize(NULL), m_epoch(0)
+        {
+        }
+
+        _reclaim_wait(const _reclaim_wait&) = delete;
+        _reclaim_wait& operator=(const _reclaim_wait&) = delete;
+
+        ~_reclaim_wait()
+        {
+            for(size_t i = 0; i < m_pins.size(); ++i)
+                m_pins[i].m_counter->release();
+        }
+
+        // For an emit_snapshot signal: waits until generation is freed. Called under the
+        // signal's lock, which keeps counter alive while the reference is taken.
+        void add(_reclaim_counter* counter, unsigned long generation)
+        {
+            pin pinned = { counter, generation };
+            m_pins.push_back(pinned);
+            counter->add_ref();
+        }
+
+        // For emit_lockfree signals, which all share one epoch domain, so that the latest
+        // epoch covers every earlier one.
+        void add(synchronize_type synchronize, unsigned long epoch)
+        {
+            m_synchronize = synchronize;
+            m_epoch = std::max(m_epoch, epoch);
+        }
+
+        void wait()
+        {
+            for(size_t i = 0; i < m_pins.size(); ++i)
+            {
+                while(m_pins[i].m_counter->m_generation.load(std::memory_order_acquire) <
+                    m_pins[i].m_generation)
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            if(m_synchronize != NULL)
+                m_synchronize(m_epoch);
+        }
+
+    private:
+        struct pin
+        {
+            _reclaim_counter* m_counter;
+            unsigned long m_generation;
+        };
+
+        std::vector<pin, _allocator<pin> > m_pins;
+        synchronize_type m_synchronize;
+        unsigned long m_epoch;
+    };
+
+    template<class mt_policy>
+    class has_slots;
+
+    // Names one connection of a signal: an entry of the signal's _connection_table, and the
+    // generation that entry had when the connection was made, which tells a stale id from the
+    // entry's current use.
+    struct _connection_id
+    {
+        unsigned m_index;
+        unsigned m_generation;
+
+        // What add_connection returns when a connection could not be made.
+        static _connection_id none()
+        {
+            _connection_id id;
+            id.m_index = ~0u;
+            id.m_generation = 0;
+            return id;
+        }
+
+        bool valid() const
+        {
+            return m_index != ~0u;
+        }
+
+        bool operator==(const _connection_id& other) const
+        {
+            return m_index == other.m_index && m_generation == other.m_generation;
+        }
+
+        bool operator<(const _connection_id& other) const
+        {
+            return m_index < other.m_index ||
+                (m_index == other.m_index && m_generation < other.m_generation);
+        }
+    };
+
+    template<class mt_policy>
+    class _signal_base : public mt_policy
+    {
+    public:
+        virtual void disconnect(has_slots<mt_policy>* pslot) = 0;
+
+        // Removes one connection. Does nothing if id was already disconnected.
+        virtual void disconnect_id(_connection_id id) = 0;
+
+        // For a receiver tearing down while it holds its own lock. Signals lock their receivers
+        // while holding their own lock, so rather than wait for this signal's lock, which could
+        // deadlock against that, this gives up and returns false if the lock is taken. Emits
+        // still running through the connection are left to the receiver to wait for through
+        // wait, once it has released its lock. Not virtual: a receiver may get here after the
+        // signal's destructor has begun, and a virtual call would read the vtable pointer that
+        // destructor is rewriting.
+        bool try_disconnect(_connection_id id, _reclaim_wait& wait)
+        {
+            return m_try_disconnect(this, id, wait);
+        }
+
+        static void disconnect_thunk(void* signal, _connection_id id)
+        {
+            static_cast<_signal_base*>(signal)->disconnect_id(id);
+        }
+
+    protected:
+        typedef bool (*try_disconnect_type)(_signal_base*, _connection_id, _reclaim_wait&);
+
+        explicit _signal_base(try_disconnect_type try_disconnect_fn)
+            : m_try_disconnect(try_disconnect_fn)
+        {
+        }
+
+    private:
+        try_disconnect_type m_try_disconnect;
+    };
+
+    // Returned by connect() to disconnect that one connection later. Disconnecting a handle
+    // twice, or after the connection went some other way, does nothing, and a default
+    // constructed handle refers to no connection. A handle must not outlive its signal.
+    class connection
+    {
+    public:
+        connection()
+            : m_signal(NULL), m_disconnect(NULL)
+        {
+            m_id.m_index = 0;
+            m_id.m_generation = 0;
+        }
+
+        template<class mt_policy>
+        connection(_signal_base<mt_policy>* signal, _connection_id id)
+            : m_signal(id.valid() ? signal : NULL),
+            m_disconnect(&_signal_base<mt_policy>::disconnect_thunk), m_id(id)
+        {
+        }
+
+        // False for a default constructed or disconnected handle, and for one returned by a
+        // connect() that failed because, under SIGSLOT_STATIC_STORAGE, the signal or the
+        // receiver was full.
+        bool connected() const
+        {
+            return m_signal != NULL;
+        }
+
+        void disconnect()
+        {
+            if(m_signal != NULL)
+            {
+                m_disconnect(m_signal, m_id);
+                m_signal = NULL;
+            }
+        }
+
+    private:
+        void* m_signal;
+        void (*m_disconnect)(void* signal, _connection_id id);
+        _connection_id m_id;
+    };
+
+    // Owns a connection and disconnects it on destruction. Like any handle it must not outlive
+    // its signal; track the connection with a connection_tracker when the signal may go first.
+    class scoped_connection
+    {
+    public:
+        scoped_connection()
+        {
+        }
+
+        scoped_connection(const connection& conn)
+            : m_conn(conn)
+        {
+        }
+
+        scoped_connection(scoped_connection&& other)
+            : m_conn(other.release())
+        {
+        }
+
+        scoped_connection(const scoped_connection&) = delete;
+        scoped_connection& operator=(const scoped_connection&) = delete;
+
+        scoped_connection& operator=(scoped_connection&& other)
+        {
+            if(this != &other)
+            {
+                m_conn.disconnect();
+                m_conn = other.release();
+            }
+
+            return *this;
+        }
+
+        scoped_connection& operator=(const connection& conn)
+        {
+            m_conn.disconnect();
+            m_conn = conn;
+            return *this;
+        }
+
+        ~scoped_connection()
+        {
+            m_conn.disconnect();
+        }
+
+        void disconnect()
+        {
+            m_conn.disconnect();
+        }
+
+        // Gives the connection up without disconnecting it.
+        connection release()
+        {
+            connection conn = m_conn;
+            m_conn = connection();
+            return conn;
+        }
+
+    private:
+        connection m_conn;
+    };
+
+    // One connection, as for_each_connection reports it on a signal or a receiver.
+    struct connection_info
+    {
+        // The signal holding the connection. For a keyed_signal, the signal of the key.
+        const void* m_signal;
+        // The slot's object, or NULL for a function object connected without a tracker.
+        const void* m_receiver;
+        // The type of the slot as the compiler spells it. NULL when enumerated from the
+        // receiver, which only knows its signals.
+        const char* m_slot_type;
+    };
+
+    typedef void (*connection_visit)(void* context, const connection_info& info);
+
+    class _sigslot_generic_class;
+
+    // A readable name for T, for tracing, taken from the compiler's own spelling of this
+    // function's signature. It contains T, if not T alone.
+    template<class T>
+    inline const char* _type_name()
+    {
+#if defined(SIGSLOT_PURE_ISO)
+        return "slot";
+#elif defined(_MSC_VER)
+        return __FUNCSIG__;
+#elif defined(__GNUC__)
+        return __PRETTY_FUNCTION__;
+#else
+        return "slot";
+#endif
+    }
+
+    // Holds any member function pointer as plain bytes, so that connections stay trivially
+    // copyable. A pointer to a member of a class that is never defined is as large as a member
+    // function pointer can get on any compiler. A small function object can live here instead.
+    struct _memfun_storage
+    {
+        template<class memfun_type>
+        void store(memfun_type pmemfun)
+        {
+            static_assert(sizeof(memfun_type) <= sizeof(m_bytes),
+                "member function pointer does not fit in _memfun_storage");
+            memcpy(m_bytes, &pmemfun, sizeof(pmemfun));
+        }
+
+        template<class memfun_type>
+        memfun_type load() const
+        {
+            memfun_type pmemfun;
+            memcpy(&pmemfun, m_bytes, sizeof(pmemfun));
+            return pmemfun;
+        }
+
+        template<class functor_type>
+        void store_functor(const functor_type& functor)
+        {
+            static_assert(std::is_trivially_copyable<functor_type>::value,
+                "a function object connected to a signal must be trivially copyable");
+            static_assert(sizeof(functor_type) <= sizeof(m_bytes) &&
+                alignof(functor_type) <= alignof(_memfun_storage),
+                "a function object connected to a signal must be no larger than two pointers");
+            new (m_bytes) functor_type(functor);
+        }
+
+        template<class functor_type>
+        const functor_type& functor() const
+        {
+            return *reinterpret_cast<const functor_type*>(m_bytes);
+        }
+
+        union
+        {
+            void (_sigslot_generic_class::*m_align)();
+            unsigned char m_bytes[sizeof(void (_sigslot_generic_class::*)())];
+        };
+    };
+
+    // Decides how an argument of type arg_type travels from emit through each connection to the
+    // slot. Small trivially copyable types go by value and everything else by const reference,
+    // so the signal never copies a large argument, however many slots are connected. Specialise
+    // it to choose differently for one of your own types.
+    template<class arg_type>
+    struct param_traits
+    {
+        typedef typename std::conditional<std::is_trivially_copyable<arg_type>::value &&
+            sizeof(arg_type) <= 2 * sizeof(void*), arg_type, const arg_type&>::type type;
+    };
+
+    template<class arg_type>
+    struct param_traits<arg_type&>
+    {
+        typedef arg_type& type;
+    };
+
+    template<size_t... indices>
+    struct _index_sequence
+    {
+        typedef _index_sequence<indices..., sizeof...(indices)> next;
+    };
+
+    template<size_t n>
+    struct _make_index_sequence
+    {
+        typedef typename _make_index_sequence<n - 1>::type::next type;
+    };
+
+    template<>
+    struct _make_index_sequence<0>
+    {
+        typedef _index_sequence<> type;
+    };
+
+    // A view of size contiguous values, as passed to emit_batch and to batch slots. Converts
+    // from a pointer and size, a std::vector or an array.
+    template<class T>
+    class span
+    {
+    public:
+        typedef T element_type;
+        typedef T* iterator;
+
+        span()
+            : m_data(NULL), m_size(0)
+        {
+        }
+
+        span(T* data, size_t size)
+            : m_data(data), m_size(size)
+        {
+        }
+
+        template<class U>
+        span(const span<U>& other)
+            : m_data(other.data()), m_size(other.size())
+        {
+        }
+
+        template<class alloc_type>
+        span(std::vector<typename std::remove_const<T>::type, alloc_type>& values)
+            : m_data(values.data()), m_size(values.size())
+        {
+        }
+
+        template<class alloc_type>
+        span(const std::vector<typename std::remove_const<T>::type, alloc_type>& values)
+            : m_data(values.data()), m_size(values.size())
+        {
+        }
+
+        template<size_t size>
+        span(T (&values)[size])
+            : m_data(values), m_size(size)
+        {
+        }
+
+        T* data() const
+        {
+            return m_data;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        iterator begin() const
+        {
+            return m_data;
+        }
+
+        iterator end() const
+        {
+            return m_data + m_size;
+        }
+
+        T& operator[](size_t i) const
+        {
+            return m_data[i];
+        }
+
+    private:
+        T* m_data;
+        size_t m_size;
+    };
+
+    // What every kind of connection holds besides its thunks: the object and member function to
+    // call, the receiver to notify on teardown and the slot's type name for tracing. The signal
+    // storage and the tracing and instrumentation probes only need this part.
+    template<class mt_policy>
+    class _connection_target
+    {
+    public:
+        has_slots<mt_policy>* getdest() const
+        {
+            return m_pdest;
+        }
+
+        // A function object connected without a tracker has no receiver to tell. Returns
+        // false if the receiver has no room for another sender.
+        bool notify_connect(_signal_base<mt_policy>* sender, _connection_id id) const
+        {
+            return m_pdest == NULL || m_pdest->signal_connect(sender, id);
+        }
+
+        void notify_disconnect(_signal_base<mt_policy>* sender, _connection_id id) const
+        {
+            if(m_pdest != NULL)
+                m_pdest->signal_disconnect(sender, id);
+        }
+
+        // The object the slot belongs to, or NULL for an untracked function object.
+        const void* receiver() const
+        {
+            return m_pdest != NULL ? static_cast<const void*>(m_pdest) : m_pobject;
+        }
+
+        void* m_pobject;
+        _memfun_storage m_pmemfun;
+        has_slots<mt_policy>* m_pdest;
+        const char* m_slot_type;
+    };
+
+    // A connection is plain data: the thunks that call the slot once or for a batch, and its
+    // _connection_target. _connection only fills it in, instantiating the thunks for the
+    // receiver type at connect() time, so emit is one indirect call with no vtable load. The
+    // single call thunk returns true if the slot asked to stop the emit.
+    template<class mt_policy, class... arg_types>
+    class _connection_base : public _connection_target<mt_policy>
+    {
+    public:
+        typedef std::tuple<arg_types...> row_type;
+        typedef bool (*invoke_type)(const _connection_base&,
+            typename param_traits<arg_types>::type...);
+
+        bool emit(typename param_traits<arg_types>::type... args) const
+        {
+            return m_invoke(*this, std::forward<typename param_traits<arg_types>::type>(args)...);
+        }
+
+        void emit_batch(span<const row_type> rows) const
+        {
+            m_invoke_batch(*this, rows);
+        }
+
+        // The batch thunk of a slot that takes one call at a time: a loop around a direct call
+        // to its single call thunk.
+        template<invoke_type invoke>
+        static void invoke_rows(const _connection_base& conn, span<const row_type> rows)
+        {
+            for(size_t i = 0; i < rows.size(); ++i)
+                invoke_row<invoke>(conn, rows[i],
+                    typename _make_index_sequence<sizeof...(arg_types)>::type());
+        }
+
+        invoke_type m_invoke;
+        void (*m_invoke_batch)(const _connection_base&, span<const row_type>);
+
+    private:
+        template<invoke_type invoke, size_t... indices>
+        static void invoke_row(const _connection_base& conn, const row_type& row,
+            _index_sequence<indices...>)
+        {
+            invoke(conn, std::get<indices>(row)...);
+        }
+    };
+
+    // Calls a slot and reports whether it stops the emit. A slot returning bool stops it by
+    // returning true; any other result is ignored.
+    template<class result_type>
+    struct _slot_call
+    {
+        template<class dest_type, class memfun_type, class... call_types>
+        static bool member(dest_type* pobject, memfun_type pmemfun, call_types&&... args)
+        {
+            (pobject->*pmemfun)(std::forward<call_types>(args)...);
+            return false;
+        }
+
+        template<class functor_type, class... call_types>
+        static bool functor(const functor_type& fn, call_types&&... args)
+        {
+            fn(std::forward<call_types>(args)...);
+            return false;
+        }
+    };
+
+    template<>
+    struct _slot_call<bool>
+    {
+        template<class dest_type, class memfun_type, class... call_types>
+        static bool member(dest_type* pobject, memfun_type pmemfun, call_types&&... args)
+        {
+            return (pobject->*pmemfun)(std::forward<call_types>(args)...);
+        }
+
+        template<class functor_type, class... call_types>
+        static bool functor(const functor_type& fn, call_types&&... args)
+        {
+            return fn(std::forward<call_types>(args)...);
+        }
+    };
+
+    template<class memfun_type>
+    struct _memfun_result;
+
+    template<class dest_type, class result_type, class... arg_types>
+    struct _memfun_result<result_type (dest_type::*)(arg_types...)>
+    {
+        typedef result_type type;
+    };
+
+    // memfun_type is the slot as declared by the receiver. Its parameters need not match the
+    // signal's exactly: a slot taking const T& for a signal of T receives the caller's object
+    // with no copy, while one taking T by value gets a copy of its own.
+    template<class dest_type, class memfun_type, class mt_policy, class... arg_types>
+    class _connection : public _connection_base<mt_policy, arg_types...>
+    {
+    public:
+        _connection(dest_type* pobject, memfun_type pmemfun)
+        {
+            this->m_invoke = &invoke;
+            this->m_invoke_batch = &_connection::template invoke_rows<&invoke>;
+            this->m_pobject = pobject;
+            this->m_pmemfun.store(pmemfun);
+            this->m_pdest = pobject;
+            this->m_slot_type = _type_name<memfun_type>();
+        }
+
+    private:
+        static bool invoke(const _connection_base<mt_policy, arg_types...>& conn,
+            typename param_traits<arg_types>::type... args)
+        {
+            return _slot_call<typename _memfun_result<memfun_type>::type>::member(
+                static_cast<dest_type*>(conn.m_pobject), conn.m_pmemfun.template load<memfun_type>(),
+                std::forward<typename param_traits<arg_types>::type>(args)...);
+        }
+    };
+
+    // A lambda, function object or free function, stored in the connection in place of the
+    // member function pointer and called as const. ptracker, if not NULL, disconnects it when
+    // destroyed. The thunk is instantiated for the function object's own type, so a stateless
+    // lambda is inlined into it.
+    template<class functor_type, class mt_policy, class... arg_types>
+    class _functor_connection : public _connection_base<mt_policy, arg_types...>
+    {
+    public:
+        _functor_connection(has_slots<mt_policy>* ptracker, const functor_type& functor)
+        {
+            this->m_invoke = &invoke;
+            this->m_invoke_batch = &_functor_connection::template invoke_rows<&invoke>;
+            this->m_pobject = NULL;
+            this->m_pmemfun.store_functor(functor);
+            this->m_pdest = ptracker;
+            this->m_slot_type = _type_name<functor_type>();
+        }
+
+    private:
+        typedef decltype(std::declval<const functor_type&>()(
+            std::declval<typename param_traits<arg_types>::type>()...)) result_type;
+
+        static bool invoke(const _connection_base<mt_policy, arg_types...>& conn,
+            typename param_traits<arg_types>::type... args)
+        {
+            return _slot_call<result_type>::functor(conn.m_pmemfun.template functor<functor_type>(),
+                std::forward<typename param_traits<arg_types>::type>(args)...);
+        }
+    };
+
+    // A slot that takes a whole batch, void fn(span<const std::tuple<arg_types...> >). A single
+    // emit reaches it as a batch of one.
+    template<class dest_type, class mt_policy, class... arg_types>
+    class _batch_connection : public _connection_base<mt_policy, arg_types...>
+    {
+    public:
+        typedef _connection_base<mt_policy, arg_types...> base_type;
+        typedef typename base_type::row_type row_type;
+        typedef void (dest_type::*memfun_type)(span<const row_type>);
+
+        _batch_connection(dest_type* pobject, memfun_type pmemfun)
+        {
+            this->m_invoke = &invoke;
+            this->m_invoke_batch = &invoke_batch;
+            this->m_pobject = pobject;
+            this->m_pmemfun.store(pmemfun);
+            this->m_pdest = pobject;
+            this->m_slot_type = _type_name<memfun_type>();
+        }
+
+    private:
+        static bool invoke(const base_type& conn, typename param_traits<arg_types>::type... args)
+        {
+            const row_type row(args...);
+            invoke_batch(conn, span<const row_type>(&row, 1));
+            return false;
+        }
+
+        static void invoke_batch(const base_type& conn, span<const row_type> rows)
+        {
+            dest_type* pobject = static_cast<dest_type*>(conn.m_pobject);
+            (pobject->*conn.m_pmemfun.template load<memfun_type>())(rows);
+        }
+    };
+
+    // The connection of a basic_result_signal: like _connection_base, but the thunk hands the
+    // slot's result back to the emit, converted to the signal's result_type.
+    template<class mt_policy, class result_type, class... arg_types>
+    class _result_connection_base : public _connection_target<mt_policy>
+    {
+    public:
+        typedef result_type (*invoke_type)(const _result_connection_base&,
+            typename param_traits<arg_types>::type...);
+
+        result_type emit(typename param_traits<arg_types>::type... args) const
+        {
+            return m_invoke(*this, std::forward<typename param_traits<arg_types>::type>(args)...);
+        }
+
+        invoke_type m_invoke;
+    };
+
+    template<class dest_type, class memfun_type, class mt_policy, class result_type,
+    class... arg_types>
+    class _result_connection : public _result_connection_base<mt_policy, result_type, arg_types...>
+    {
+    public:
+        _result_connection(dest_type* pobject, memfun_type pmemfun)
+        {
+            this->m_invoke = &invoke;
+            this->m_pobject = pobject;
+            this->m_pmemfun.store(pmemfun);
+            this->m_pdest = pobject;
+            this->m_slot_type = _type_name<memfun_type>();
+        }
+
+    private:
+        static result_type invoke(
+            const _result_connection_base<mt_policy, result_type, arg_types...>& conn,
+            typename param_traits<arg_types>::type... args)
+        {
+            dest_type* pobject = static_cast<dest_type*>(conn.m_pobject);
+            return (pobject->*conn.m_pmemfun.template load<memfun_type>())(
+                std::forward<typename param_traits<arg_types>::type>(args)...);
+        }
+    };
+
+    template<class functor_type, class mt_policy, class result_type, class... arg_types>
+    class _result_functor_connection
+        : public _result_connection_base<mt_policy, result_type, arg_types...>
+    {
+    public:
+        _result_functor_connection(has_slots<mt_policy>* ptracker, const functor_type& functor)
+        {
+            this->m_invoke = &invoke;
+            this->m_pobject = NULL;
+            this->m_pmemfun.store_functor(functor);
+            this->m_pdest = ptracker;
+            this->m_slot_type = _type_name<functor_type>();
+        }
+
+    private:
+        static result_type invoke(
+            const _result_connection_base<mt_policy, result_type, arg_types...>& conn,
+            typename param_traits<arg_types>::type... args)
+        {
+            return conn.m_pmemfun.template functor<functor_type>()(
+                std::forward<typename param_traits<arg_types>::type>(args)...);
+        }
+    };
+
+    template<class... arg_types>
+    struct _has_mutable_reference : std::false_type
+    {
+    };
+
+    template<class arg_type, class... arg_types>
+    struct _has_mutable_reference<arg_type, arg_types...>
+        : std::integral_constant<bool, (std::is_lvalue_reference<arg_type>::value &&
+            !std::is_const<typename std::remove_reference<arg_type>::type>::value) ||
+            _has_mutable_reference<arg_types...>::value>
+    {
+    };
+
+    // Tells queued messages whether their receiver still exists. Shared by the receiver and
+    // every message queued for it, and freed by whichever lets go last.
+    class _receiver_token : public _allocated_object
+    {
+    public:
+        _receiver_token()
+            : m_refs(1), m_alive(true)
+        {
+        }
+
+        void add_ref()
+        {
+            m_refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release()
+        {
+            if(m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete this;
+        }
+
+        bool alive() const
+        {
+            return m_alive.load(std::memory_order_acquire);
+        }
+
+        void expire()
+        {
+            m_alive.store(false, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<unsigned long> m_refs;
+        std::atomic<bool> m_alive;
+    };
+
+    // A call waiting in an event_queue. m_run makes the call, unless deliver is false, and then
+    // frees the message.
+    struct _queued_message : public _allocated_object
+    {
+        void (*m_run)(_queued_message*, bool deliver);
+        _queued_message* m_next;
+    };
+
+    // A message whose handler may hand it back to the queue to run again later, through
+    // event_queue::defer, rather than posting a new one.
+    struct _deferred_message : public _queued_message
+    {
+        std::chrono::steady_clock::time_point m_due;
+    };
+
+    // The receiving end of queued connections: any number of threads post to it, and the one
+    // thread that owns it runs process() from its event loop to call the slots there. Posting
+    // pushes onto a lock-free stack with a compare-and-swap, retried only while other threads
+    // are posting at the same moment, and process() takes the whole stack with one exchange.
+    // The notify function, if set, is called by the posting thread when a message lands in an
+    // empty queue, so a busy receiver is woken once per batch rather than once per message.
+    // Set it before connecting anything. The queue must outlive the receivers connected
+    // through it, and those receivers should be destroyed on the queue's thread: a message for
+    // a receiver that has since been destroyed is dropped by process(), but nothing stops a
+    // receiver being destroyed during the call itself.
+    //
+    // A message may also be deferred to a later time by its own handler. Deferred messages do
+    // not count towards empty() and wake no one: the event loop finds the earliest with
+    // next_deadline(), and arms a timer to call process() then.
+    class event_queue
+    {
+    public:
+        typedef void (*notify_function)(void* context);
+        typedef std::chrono::steady_clock::time_point time_point;
+
+        event_queue()
+            : m_head(NULL), m_notify(NULL), m_context(NULL), m_deferred(NULL)
+        {
+        }
+
+        event_queue(const event_queue&) = delete;
+        event_queue& operator=(const event_queue&) = delete;
+
+        // Messages still waiting are discarded without being delivered.
+        ~event_queue()
+        {
+            discard(m_head.exchange(NULL, std::memory_order_acquire));
+            discard(m_deferred);
+        }
+
+        void set_notify(notify_function notify, void* context)
+        {
+            m_notify = notify;
+            m_context = context;
+        }
+
+        bool empty() const
+        {
+            return m_head.load(std::memory_order_relaxed) == NULL;
+        }
+
+        // Delivers the deferred messages now due and everything posted so far, in the order it
+        // was posted, and returns the number of messages handled. Messages posted or deferred
+        // by the slots themselves wait for the next call.
+        size_t process()
+        {
+            size_t count = 0;
+
+            if(m_deferred != NULL)
+            {
+                time_point now = std::chrono::steady_clock::now();
+                _queued_message* due = NULL;
+                _queued_message** tail = &due;
+
+                while(m_deferred != NULL && static_cast<_deferred_message*>(m_deferred)->m_due <= now)
+                {
+                    *tail = m_deferred;
+                    tail = &m_deferred->m_next;
+                    m_deferred = m_deferred->m_next;
+                }
+
+                *tail = NULL;
+                count += run(due);
+            }
+
+            _queued_message* batch = m_head.exchange(NULL, std::memory_order_acquire);
+            _queued_message* ordered = NULL;
+
+            while(batch != NULL)
+            {
+                _queued_message* next = batch->m_next;
+                batch->m_next = ordered;
+                ordered = batch;
+                batch = next;
+            }
+
+            return count + run(ordered);
+        }
+
+        // For a handler running on the queue's thread: keeps msg, instead of freeing it, to be
+        // run again by the first process() at or after due.
+        void defer(_deferred_message* msg, time_point due)
+        {
+            msg->m_due = due;
+            _queued_message** pos = &m_deferred;
+
+            while(*pos != NULL && static_cast<_deferred_message*>(*pos)->m_due <= due)
+                pos = &(*pos)->m_next;
+
+            msg->m_next = *pos;
+            *pos = msg;
+        }
+
+        // When the earliest deferred message is due, or time_point::max() if there is none.
+        // Only meaningful on the queue's thread.
+        time_point next_deadline() const
+        {
+            return m_deferred != NULL ? static_cast<_deferred_message*>(m_deferred)->m_due
+                                      : time_point::max();
+        }
+
+        void post(_queued_message* msg)
+        {
+            _queued_message* head = m_head.load(std::memory_order_relaxed);
+
+            do
+            {
+                msg->m_next = head;
+            }
+            while(!m_head.compare_exchange_weak(head, msg, std::memory_order_release,
+                std::memory_order_relaxed));
+
+            if(head == NULL && m_notify != NULL)
+                m_notify(m_context);
+        }
+
+    private:
+        static size_t run(_queued_message* msg)
+        {
+            size_t count = 0;
+
+            while(msg != NULL)
+            {
+                _queued_message* next = msg->m_next;
+                msg->m_run(msg, true);
+                msg = next;
+                ++count;
+            }
+
+            return count;
+        }
+
+        static void discard(_queued_message* msg)
+        {
+            while(msg != NULL)
+            {
+                _queued_message* next = msg->m_next;
+                msg->m_run(msg, false);
+                msg = next;
+            }
+        }
+
+        std::atomic<_queued_message*> m_head;
+        notify_function m_notify;
+        void* m_context;
+        // _deferred_message entries sorted by due time. Only touched on the queue's thread.
+        _queued_message* m_deferred;
+    };
+
+    // Selects a queued connection: signal.connect(&obj, &T::fn, sigslot::queued(queue)).
+    struct queued_connection
+    {
+        explicit queued_connection(event_queue& queue)
+            : m_queue(&queue)
+        {
+        }
+
+        event_queue* m_queue;
+    };
+
+    inline queued_connection queued(event_queue& queue)
+    {
+        return queued_connection(queue);
+    }
+
+    // One queued call: the receiver, the slot and a copy of every argument.
+    template<class dest_type, class memfun_type, class... value_types>
+    class _queued_call : public _queued_message
+    {
+    public:
+        template<class... arg_types>
+        _queued_call(_receiver_token* token, dest_type* pobject, memfun_type pmemfun,
+            arg_types&&... args)
+            : m_token(token), m_pobject(pobject), m_pmemfun(pmemfun),
+            m_args(std::forward<arg_types>(args)...)
+        {
+            m_run = &run;
+            m_token->add_ref();
+        }
+
+    private:
+        static void run(_queued_message* msg, bool deliver)
+        {
+            _queued_call* call = static_cast<_queued_call*>(msg);
+
+            if(deliver && call->m_token->alive())
+                call->invoke(typename _make_index_sequence<sizeof...(value_types)>::type());
+
+            call->m_token->release();
+            delete call;
+        }
+
+        template<size_t... indices>
+        void invoke(_index_sequence<indices...>)
+        {
+            (m_pobject->*m_pmemfun)(std::get<indices>(m_args)...);
+        }
+
+        _receiver_token* m_token;
+        dest_type* m_pobject;
+        memfun_type m_pmemfun;
+        std::tuple<value_types...> m_args;
+    };
+
+    // Fills in a connection whose thunk copies the arguments into a _queued_call and posts it
+    // instead of calling the slot. The connection has no room for the queue as well as the
+    // object, so m_pobject holds the queue and the object is recovered from m_pdest.
+    template<class dest_type, class memfun_type, class mt_policy, class... arg_types>
+    class _queued_connection : public _connection_base<mt_policy, arg_types...>
+    {
+    public:
+        _queued_connection(dest_type* pobject, memfun_type pmemfun, event_queue* queue)
+        {
+            this->m_invoke = &invoke;
+            this->m_invoke_batch = &_queued_connection::template invoke_rows<&invoke>;
+            this->m_pobject = queue;
+            this->m_pmemfun.store(pmemfun);
+            this->m_pdest = pobject;
+            this->m_slot_type = _type_name<memfun_type>();
+        }
+
+    private:
+        typedef _queued_call<dest_type, memfun_type, typename std::decay<arg_types>::type...>
+            call_type;
+
+        static bool invoke(const _connection_base<mt_policy, arg_types...>& conn,
+            typename param_traits<arg_types>::type... args)
+        {
+            event_queue* queue = static_cast<event_queue*>(conn.m_pobject);
+            queue->post(new call_type(conn.m_pdest->token(), static_cast<dest_type*>(conn.m_pdest),
+                conn.m_pmemfun.template load<memfun_type>(), args...));
+            return false;
+        }
+    };
+
+    // The part of std::vector the locked signal storage uses, in an array of capacity elements
+    // inside the object, for SIGSLOT_STATIC_STORAGE. Callers check full() before adding.
+    template<class T, size_t capacity>
+    class _fixed_vector
+    {
+    public:
+        typedef T* iterator;
+        typedef const T* const_iterator;
+
+        static_assert(std::is_trivially_copyable<T>::value,
+            "_fixed_vector moves its elements with memcpy");
+
+        _fixed_vector()
+            : m_size(0)
+        {
+        }
+
+        iterator begin()
+        {
+            return data();
+        }
+
+        iterator end()
+        {
+            return data() + m_size;
+        }
+
+        const_iterator begin() const
+        {
+            return data();
+        }
+
+        const_iterator end() const
+        {
+            return data() + m_size;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        bool full() const
+        {
+            return m_size == capacity;
+        }
+
+        T& operator[](size_t i)
+        {
+            return data()[i];
+        }
+
+        const T& operator[](size_t i) const
+        {
+            return data()[i];
+        }
+
+        void push_back(const T& value)
+        {
+            memcpy(static_cast<void*>(data() + m_size), &value, sizeof(T));
+            ++m_size;
+        }
+
+        iterator insert(iterator pos, const T& value)
+        {
+            memmove(static_cast<void*>(pos + 1), pos, (end() - pos) * sizeof(T));
+            memcpy(static_cast<void*>(pos), &value, sizeof(T));
+            ++m_size;
+            return pos;
+        }
+
+        void erase(iterator first, iterator last)
+        {
+            memmove(static_cast<void*>(first), last, (end() - last) * sizeof(T));
+            m_size -= last - first;
+        }
+
+        void clear()
+        {
+            m_size = 0;
+        }
+
+        void reserve(size_t)
+        {
+        }
+
+    private:
+        T* data()
+        {
+            return reinterpret_cast<T*>(m_storage);
+        }
+
+        const T* data() const
+        {
+            return reinterpret_cast<const T*>(m_storage);
+        }
+
+        size_t m_size;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage[capacity];
+    };
+
+    // The array a signal keeps its connections and their ids in.
+#ifdef SIGSLOT_STATIC_STORAGE
+    template<class T>
+    struct _signal_vector
+    {
+        typedef _fixed_vector<T, SIGSLOT_MAX_SLOTS> type;
+    };
+#else
+    template<class T>
+    struct _signal_vector
+    {
+        typedef std::vector<T, _allocator<T> > type;
+    };
+#endif
+
+    template<class T, class allocator_type>
+    inline bool _at_capacity(const std::vector<T, allocator_type>&, size_t)
+    {
+        return false;
+    }
+
+    template<class T, size_t capacity>
+    inline bool _at_capacity(const _fixed_vector<T, capacity>&, size_t size)
+    {
+        return size >= capacity;
+    }
+
+    template<class T, class allocator_type>
+    inline size_t _heap_bytes(const std::vector<T, allocator_type>& v)
+    {
+        return v.capacity() * sizeof(T);
+    }
+
+    template<class T, size_t capacity>
+    inline size_t _heap_bytes(const _fixed_vector<T, capacity>&)
+    {
+        return 0;
+    }
+
+    // The emit models other than the locked one copy connection arrays on the heap.
+    template<class connection_base>
+    struct _uses_static_storage
+#ifdef SIGSLOT_STATIC_STORAGE
+        : std::true_type
+#else
+        : std::false_type
+#endif
+    {
+    };
+
+    // One connection stored by value, together with its entry in the signal's _connection_table
+    // and the flag emit checks to skip a slot that was disconnected while an emit was walking
+    // the array. All are trivially copyable, so a signal's connections live in one contiguous
+    // array that is copied and compacted like plain memory.
+    template<class connection_base>
+    class _connection_slot
+    {
+    public:
+        _connection_slot(const connection_base& conn, unsigned index)
+            : m_conn(conn), m_index(index), m_disconnected(false)
+        {
+            static_assert(std::is_trivially_copyable<_connection_slot>::value,
+                "connections must be trivially copyable");
+        }
+
+        const connection_base* operator->() const
+        {
+            return &m_conn;
+        }
+
+        unsigned index() const
+        {
+            return m_index;
+        }
+
+        bool disconnected() const
+        {
+            return m_disconnected;
+        }
+
+        void set_disconnected()
+        {
+            m_disconnected = true;
+        }
+
+    private:
+        connection_base m_conn;
+        unsigned m_index;
+        bool m_disconnected;
+    };
+
+    // Where each of a signal's connection ids currently sits in its array of slots, so that a
+    // connection is found without a search however often the array is compacted or copied,
+    // and its priority, which keeps the slots themselves no larger than a cache line.
+    // Released entries are reused, with their generation bumped so that the old id no longer
+    // matches. Only used with the signal lock held.
+    class _connection_table
+    {
+    public:
+        _connection_table()
+            : m_free(none)
+        {
+        }
+
+        _connection_id acquire(size_t position, int priority)
+        {
+            _connection_id id;
+
+            if(m_free != none)
+            {
+                id.m_index = m_free;
+                m_free = m_entries[m_free].m_position;
+            }
+            else
+            {
+                id.m_index = static_cast<unsigned>(m_entries.size());
+                m_entries.push_back(entry());
+            }
+
+            m_entries[id.m_index].m_position = static_cast<unsigned>(position);
+            m_entries[id.m_index].m_priority = priority;
+            id.m_generation = m_entries[id.m_index].m_generation;
+            _count_connection(true);
+            return id;
+        }
+
+        void release(unsigned index)
+        {
+            ++m_entries[index].m_generation;
+            m_entries[index].m_position = m_free;
+            m_free = index;
+            _count_connection(false);
+        }
+
+        // Returns false if id has been released.
+        bool find(_connection_id id, size_t& position) const
+        {
+            if(id.m_index >= m_entries.size() || m_entries[id.m_index].m_generation != id.m_generation)
+                return false;
+
+            position = m_entries[id.m_index].m_position;
+            return true;
+        }
+
+        _connection_id id(unsigned index) const
+        {
+            _connection_id id;
+            id.m_index = index;
+            id.m_generation = m_entries[index].m_generation;
+            return id;
+        }
+
+        void move(unsigned index, size_t position)
+        {
+            m_entries[index].m_position = static_cast<unsigned>(position);
+        }
+
+        // Records the positions of slots[from] onwards after they were moved. A disconnected
+        // slot's entry has been released, and may already belong to another connection.
+        template<class connections_vector>
+        void renumber(const connections_vector& slots, size_t from)
+        {
+            for(size_t i = from; i < slots.size(); ++i)
+            {
+                if(!slots[i].disconnected())
+                    move(slots[i].index(), i);
+            }
+        }
+
+        int priority(unsigned index) const
+        {
+            return m_entries[index].m_priority;
+        }
+
+        // Where a connection of the given priority goes in slots, which are sorted by descending
+        // priority: after every slot of the same or higher priority, so that slots of equal
+        // priority are called in connection order. Disconnected slots are passed over, since
+        // their entries may have been reused. Connecting at the lowest priority present, as
+        // most connections do, appends.
+        template<class connections_vector>
+        size_t insert_position(const connections_vector& slots, int priority) const
+        {
+            size_t position = slots.size();
+
+            while(position > 0 && (slots[position - 1].disconnected() ||
+                m_entries[slots[position - 1].index()].m_priority < priority))
+            {
+                --position;
+            }
+
+            return position;
+        }
+
+        size_t heap_bytes() const
+        {
+            return _heap_bytes(m_entries);
+        }
+
+        // Orders connected slots by descending priority.
+        struct higher_priority
+        {
+            template<class slot_type>
+            bool operator()(const slot_type& a, const slot_type& b) const
+            {
+                return m_table->priority(a.index()) > m_table->priority(b.index());
+            }
+
+            const _connection_table* m_table;
+        };
+
+    private:
+        static const unsigned none = ~0u;
+
+        // While an entry is free, m_position links it to the next free one.
+        struct entry
+        {
+            entry()
+                : m_position(0), m_generation(0), m_priority(0)
+            {
+            }
+
+            unsigned m_position;
+            unsigned m_generation;
+            int m_priority;
+        };
+
+        typename _signal_vector<entry>::type m_entries;
+        unsigned m_free;
+    };
+
+    // Each thread keeps a stack of the emits it is currently inside. A locked emit holds the
+    // signal lock throughout, so a slot calling back into that signal knows its thread owns
+    // the lock already, and a snapshot emit's disconnect knows not to wait for itself.
+    struct _emit_frame
+    {
+        const void* m_signal;
+        _emit_frame* m_prev;
+    };
+
+    inline _emit_frame*& _current_emit_frame()
+    {
+        static thread_local _emit_frame* frame = NULL;
+        return frame;
+    }
+
+    // The locked signal whose emit_parallel this thread is calling slots for, if any. The
+    // emitting thread holds that signal's lock throughout, while other threads call its slots
+    // too, so none of those slots may call back into the signal.
+    inline const void*& _parallel_emit_signal()
+    {
+        static thread_local const void* signal = NULL;
+        return signal;
+    }
+
+    inline bool _is_emitting(const void* signal)
+    {
+        for(_emit_frame* frame = _current_emit_frame(); frame != NULL; frame = frame->m_prev)
+        {
+            if(frame->m_signal == signal)
+                return true;
+        }
+
+        return false;
+    }
+
+    // Takes the lock of a signal with a locked emit model, unless this thread is inside an emit
+    // of that signal and so holds it already. This is what lets a slot connect, disconnect,
+    // re-emit or destroy its receiver under a non-recursive mutex.
+    template<class signal_type>
+    class _emit_lock_block
+    {
+    public:
+        _emit_lock_block(signal_type* signal)
+            : m_signal(_is_emitting(signal) ? NULL : signal)
+        {
+            assert(_parallel_emit_signal() != signal &&
+                "a slot of a locked emit_parallel called back into its signal");
+
+            if(m_signal != NULL)
+                _lock_traced(m_signal);
+        }
+
+        ~_emit_lock_block()
+        {
+            if(m_signal != NULL)
+                _unlock_traced(m_signal);
+        }
+
+    private:
+        signal_type* m_signal;
+    };
+
+    // Walks a signal's slots as an emit would, so that in every emit model the visit may
+    // connect to or disconnect from the signal, and connections made meanwhile are not seen.
+    template<class storage_type>
+    void _visit_connections(storage_type* signal, connection_visit visit, void* context)
+    {
+        typename storage_type::emit_scope scope(signal);
+
+        for(size_t i = 0; i < scope.size(); ++i)
+        {
+            if(!scope[i].disconnected())
+            {
+                connection_info info = { signal, scope[i]->receiver(), scope[i]->m_slot_type };
+                visit(context, info);
+            }
+        }
+    }
+
+    // Picks the connections a disconnect removes: those of one receiver, or every one if it
+    // is NULL.
+    template<class mt_policy>
+    struct _receiver_match
+    {
+        explicit _receiver_match(const has_slots<mt_policy>* receiver)
+            : m_receiver(receiver)
+        {
+        }
+
+        bool operator()(const has_slots<mt_policy>* dest) const
+        {
+            return m_receiver == NULL || dest == m_receiver;
+        }
+
+        const has_slots<mt_policy>* m_receiver;
+    };
+
+    // Picks those of any receiver in a range, for disconnect_all_of. The range is copied and
+    // sorted before the signal is locked, so that each slot costs one binary search.
+    template<class mt_policy>
+    class _receiver_set
+    {
+    public:
+        template<class iterator_type>
+        _receiver_set(iterator_type first, iterator_type last)
+            : m_receivers(first, last)
+        {
+            std::sort(m_receivers.begin(), m_receivers.end());
+        }
+
+        bool operator()(const has_slots<mt_policy>* dest) const
+        {
+            return dest != NULL && std::binary_search(m_receivers.begin(), m_receivers.end(), dest);
+        }
+
+    private:
+        std::vector<const has_slots<mt_policy>*, _allocator<const has_slots<mt_policy>*> >
+            m_receivers;
+    };
+
+    // A signal keeps its connections in a _signal_storage, which also owns the connect,
+    // disconnect and teardown logic. The emit model of the threading
+    // policy picks the specialisation: emit_locked walks m_connected_slots under the policy lock,
+    // emit_snapshot walks an immutable snapshot with no lock held and emit_lockfree reads an
+    // epoch protected array without touching any shared state. In every model an emit_scope
+    // exposes the slots to call as an indexed array.
+    template<class connection_base, class mt_policy,
+    class emit_model = typename _emit_model<mt_policy>::type>
+    class _signal_storage;
+
+    template<class connection_base, class mt_policy>
+    class _signal_storage<connection_base, mt_policy, emit_locked> : public _signal_base<mt_policy>
+    {
+    public:
+        typedef _connection_slot<connection_base> slot_type;
+        typedef typename _signal_vector<slot_type>::type connections_vector;
+
+        // Holds the signal lock for the duration of an emit, and lets slots running on this
+        // thread call back into the signal without locking it again. Only slots connected
+        // before the emit started are called. While any emit is in progress a disconnect only
+        // marks its slot and a connect goes to m_pending, so the array an emit is walking never
+        // moves; the outermost emit sweeps both on exit.
+        class emit_scope
+        {
+        public:
+            emit_scope(_signal_storage* signal)
+                : m_lock(signal), m_signal(signal), m_size(signal->m_connected_slots.size())
+            {
+                ++m_signal->m_emitting;
+                m_frame.m_signal = signal;
+                m_frame.m_prev = _current_emit_frame();
+                _current_emit_frame() = &m_frame;
+            }
+
+            ~emit_scope()
+            {
+                _current_emit_frame() = m_frame.m_prev;
+
+                if(--m_signal->m_emitting == 0 && m_signal->m_dirty)
+                    m_signal->compact();
+            }
+
+            size_t size() const
+            {
+                return m_size;
+            }
+
+            const slot_type& operator[](size_t i) const
+            {
+                return m_signal->m_connected_slots[i];
+            }
+
+        private:
+            _emit_lock_block<_signal_storage> m_lock;
+            _signal_storage* m_signal;
+            size_t m_size;
+            _emit_frame m_frame;
+        };
+
+        _signal_storage()
+            : _signal_base<mt_policy>(&try_disconnect_thunk), m_emitting(0), m_dirty(false),
+            m_disconnected(0)
+        {
+        }
+
+        ~_signal_storage()
+        {
+            lock_block<mt_policy> lock(this);
+            remove_connections(_receiver_match<mt_policy>(NULL));
+        }
+
+        void disconnect(has_slots<mt_policy>* pslot = NULL)
+        {
+            _emit_lock_block<_signal_storage> lock(this);
+            remove_connections(_receiver_match<mt_policy>(pslot));
+        }
+
+        // Disconnects every receiver in [first, last) under one lock, in one pass over the
+        // slots and with at most one compaction.
+        template<class iterator_type>
+        void disconnect_all_of(iterator_type first, iterator_type last)
+        {
+            _receiver_set<mt_policy> receivers(first, last);
+            _emit_lock_block<_signal_storage> lock(this);
+            remove_connections(receivers);
+        }
+
+        void disconnect_id(_connection_id id)
+        {
+            _emit_lock_block<_signal_storage> lock(this);
+            remove_connection(id, true);
+        }
+
+        // The receiver forgets the connection itself, so it is not called back. A receiver
+        // destroyed by one of this signal's slots finds the lock already held by its thread.
+        // Emits run under the lock, so there is nothing left to wait for.
+        bool try_disconnect(_connection_id id, _reclaim_wait&)
+        {
+            assert(_parallel_emit_signal() != this &&
+                "a slot of a locked emit_parallel destroyed a receiver of its signal");
+            bool owned = _is_emitting(this);
+
+            if(!owned && !this->try_lock())
+                return false;
+
+            remove_connection(id, false);
+
+            if(!owned)
+                this->unlock();
+
+            return true;
+        }
+
+        static bool try_disconnect_thunk(_signal_base<mt_policy>* signal, _connection_id id,
+            _reclaim_wait& wait)
+        {
+            return static_cast<_signal_storage*>(signal)->try_disconnect(id, wait);
+        }
+
+        // Makes room for n connections, so that connecting up to that many does not reallocate.
+        void reserve(size_t n)
+        {
+            _emit_lock_block<_signal_storage> lock(this);
+
+            if(m_emitting == 0)
+                m_connected_slots.reserve(n);
+        }
+
+        void for_each_connection(connection_visit visit, void* context)
+        {
+            _visit_connections(this, visit, context);
+        }
+
+        // The heap memory the signal holds for its connections, on top of its own size.
+        size_t heap_bytes()
+        {
+            _emit_lock_block<_signal_storage> lock(this);
+            return _heap_bytes(m_connected_slots) + _heap_bytes(m_pending) + m_ids.heap_bytes();
+        }
+
+    protected:
+        // Returns _connection_id::none() if the signal or the receiver is full, which only
+        // happens under SIGSLOT_STATIC_STORAGE.
+        _connection_id add_connection(const connection_base& conn, int priority)
+        {
+            _emit_lock_block<_signal_storage> lock(this);
+            _connection_id id;
+
+            if(_at_capacity(m_connected_slots,
+                m_connected_slots.size() + m_pending.size() - m_disconnected))
+            {
+                return _connection_id::none();
+            }
+
+            if(m_emitting == 0)
+            {
+                if(_at_capacity(m_connected_slots, m_connected_slots.size()))
+                    compact();
+
+                size_t position = m_ids.insert_position(m_connected_slots, priority);
+                id = m_ids.acquire(position, priority);
+                m_connected_slots.insert(m_connected_slots.begin() + position,
+                    slot_type(conn, id.m_index));
+                m_ids.renumber(m_connected_slots, position + 1);
+            }
+            else
+            {
+                id = m_ids.acquire(m_connected_slots.size() + m_pending.size(), priority);
+                m_pending.push_back(slot_type(conn, id.m_index));
+                m_dirty = true;
+            }
+
+            if(!conn.notify_connect(this, id))
+            {
+                remove_connection(id, false);
+                return _connection_id::none();
+            }
+
+            return id;
+        }
+
+        // Connects make(*it) for each element of [first, last), all at one priority, under one
+        // lock, growing the array once and moving the slots after the insertion point once.
+        // Each receiver is told of its connection before the slot is stored, so one that has
+        // no room is simply skipped. Returns how many were connected, which is fewer only
+        // under SIGSLOT_STATIC_STORAGE.
+        template<class iterator_type, class make_type>
+        size_t add_connections(iterator_type first, iterator_type last, make_type make,
+            int priority)
+        {
+            _emit_lock_block<_signal_storage> lock(this);
+            size_t count = std::distance(first, last);
+            bool emitting = m_emitting != 0;
+
+            if(!emitting && m_disconnected != 0 &&
+                _at_capacity(m_connected_slots, m_connected_slots.size() + count))
+            {
+                compact();
+            }
+
+            connections_vector& slots = emitting ? m_pending : m_connected_slots;
+            size_t start = slots.size();
+            size_t position = emitting ? m_connected_slots.size() + start :
+                m_ids.insert_position(m_connected_slots, priority);
+            size_t live = m_connected_slots.size() + m_pending.size() - m_disconnected;
+            slots.reserve(start + count);
+
+            for(; first != last; ++first)
+            {
+                if(_at_capacity(slots, slots.size()) || _at_capacity(m_connected_slots, live))
+                    break;
+
+                connection_base conn = make(*first);
+                _connection_id id = m_ids.acquire(position + slots.size() - start, priority);
+
+                if(!conn.notify_connect(this, id))
+                {
+                    m_ids.release(id.m_index);
+                    continue;
+                }
+
+                slots.push_back(slot_type(conn, id.m_index));
+                ++live;
+            }
+
+            size_t made = slots.size() - start;
+
+            if(emitting)
+            {
+                m_dirty = m_dirty || made != 0;
+            }
+            else if(position != start)
+            {
+                std::rotate(slots.begin() + position, slots.begin() + start, slots.end());
+                m_ids.renumber(slots, position + made);
+            }
+
+            return made;
+        }
+
+    private:
+        // Positions past the end of m_connected_slots are in m_pending.
+        slot_type& slot_at(size_t position)
+        {
+            if(position < m_connected_slots.size())
+                return m_connected_slots[position];
+
+            return m_pending[position - m_connected_slots.size()];
+        }
+
+        // Called with the signal lock held. The slot is only marked, and the array compacted
+        // once marked slots make up half of it, so a disconnect takes amortised constant time.
+        void remove_connection(_connection_id id, bool notify)
+        {
+            size_t position;
+
+            if(!m_ids.find(id, position))
+                return;
+
+            slot_type& slot = slot_at(position);
+
+            if(notify)
+                slot->notify_disconnect(this, id);
+
+            slot.set_disconnected();
+            m_ids.release(id.m_index);
+
+            if(++m_disconnected * 2 >= m_connected_slots.size() + m_pending.size())
+            {
+                if(m_emitting == 0)
+                    compact();
+                else
+                    m_dirty = true;
+            }
+        }
+
+        // Called with the signal lock held. Removes every connection whose receiver match
+        // picks.
+        template<class match_type>
+        void remove_connections(const match_type& match)
+        {
+            bool found = remove_matching(m_connected_slots, match);
+            found = remove_matching(m_pending, match) || found;
+
+            if(found)
+            {
+                if(m_emitting == 0)
+                    compact();
+                else
+                    m_dirty = true;
+            }
+        }
+
+        template<class match_type>
+        bool remove_matching(connections_vector& slots, const match_type& match)
+        {
+            typename connections_vector::iterator it = slots.begin();
+            typename connections_vector::iterator itEnd = slots.end();
+            bool found = false;
+
+            while(it != itEnd)
+            {
+                if(!it->disconnected() && match((*it)->getdest()))
+                {
+                    (*it)->notify_disconnect(this, m_ids.id(it->index()));
+                    it->set_disconnected();
+                    m_ids.release(it->index());
+                    ++m_disconnected;
+                    found = true;
+                }
+
+                ++it;
+            }
+
+            return found;
+        }
+
+        // Called once no emit is walking the array. Removes the disconnected slots, keeping the
+        // others in order, and appends the connections made during emits. Those are then moved
+        // into place if any has a higher priority than the slots before it; there are few, so
+        // each is rotated into place rather than merged, which needs no buffer.
+        void compact()
+        {
+            size_t kept = 0;
+
+            for(size_t i = 0; i < m_connected_slots.size(); ++i)
+            {
+                if(!m_connected_slots[i].disconnected())
+                {
+                    if(kept != i)
+                    {
+                        m_connected_slots[kept] = m_connected_slots[i];
+                        m_ids.move(m_connected_slots[kept].index(), kept);
+                    }
+
+                    ++kept;
+                }
+            }
+
+            m_connected_slots.erase(m_connected_slots.begin() + kept, m_connected_slots.end());
+            size_t connected = kept;
+
+            for(size_t i = 0; i < m_pending.size(); ++i)
+            {
+                if(!m_pending[i].disconnected())
+                {
+                    m_ids.move(m_pending[i].index(), m_connected_slots.size());
+                    m_connected_slots.push_back(m_pending[i]);
+                }
+            }
+
+            m_pending.clear();
+            m_disconnected = 0;
+
+            typename connections_vector::iterator first = m_connected_slots.begin();
+            _connection_table::higher_priority order = { &m_ids };
+            size_t moved = m_connected_slots.size();
+
+            for(size_t i = connected; i < m_connected_slots.size(); ++i)
+            {
+                typename connections_vector::iterator slot = first + i;
+                typename connections_vector::iterator pos = std::upper_bound(first, slot, *slot,
+                    order);
+
+                if(pos != slot)
+                {
+                    std::rotate(pos, slot, slot + 1);
+                    moved = std::min<size_t>(moved, pos - first);
+                }
+            }
+
+            m_ids.renumber(m_connected_slots, moved);
+            m_dirty = false;
+        }
+
+        unsigned m_emitting;
+        bool m_dirty;
+        size_t m_disconnected;
+        _connection_table m_ids;
+        connections_vector m_pending;
+
+    protected:
+        connections_vector m_connected_slots;
+    };
+
+    // The locked model with emit taking the lock shared. Connect and disconnect still take it
+    // exclusively, so no slot can be marked disconnected while an emit holds it, and the emit
+    // leaves the locked model's bookkeeping alone. A slot must not connect to or disconnect
+    // from the signal that is calling it.
+    template<class connection_base, class mt_policy>
+    class _signal_storage<connection_base, mt_policy, emit_shared>
+        : public _signal_storage<connection_base, mt_policy, emit_locked>
+    {
+    public:
+        typedef _signal_storage<connection_base, mt_policy, emit_locked> locked_type;
+        typedef typename locked_type::slot_type slot_type;
+
+        class emit_scope
+        {
+        public:
+            emit_scope(_signal_storage* signal)
+                : m_lock(signal), m_signal(signal), m_size(signal->m_connected_slots.size())
+            {
+            }
+
+            size_t size() const
+            {
+                return m_size;
+            }
+
+            const slot_type& operator[](size_t i) const
+            {
+                return m_signal->m_connected_slots[i];
+            }
+
+        private:
+            lock_block_shared<mt_policy> m_lock;
+            _signal_storage* m_signal;
+            size_t m_size;
+        };
+    };
+
+    // An immutable, reference counted copy of a signal's connections. Every snapshot holds a
+    // reference to the one published after it, so snapshots are always freed oldest first and
+    // the signal can tell when no emit is using a given generation any more.
+    template<class connection_base>
+    class _connection_snapshot : public _allocated_object
+    {
+    public:
+        typedef _connection_slot<connection_base> slot_type;
+        typedef std::vector<slot_type, _allocator<slot_type> > connections_vector;
+
+        _connection_snapshot(unsigned long generation, _reclaim_counter* reclaimed)
+            : m_next(NULL), m_generation(generation), m_reclaimed(reclaimed), m_refs(1)
+        {
+        }
+
+        ~_connection_snapshot()
+        {
+            m_reclaimed->m_generation.store(m_generation, std::memory_order_release);
+        }
+
+        void acquire()
+        {
+            m_refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static void release(_connection_snapshot* snapshot)
+        {
+            while(snapshot != NULL && snapshot->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                _connection_snapshot* next = snapshot->m_next;
+                delete snapshot;
+                snapshot = next;
+            }
+        }
+
+        connections_vector m_connections;
+        _connection_snapshot* m_next;
+        const unsigned long m_generation;
+
+    private:
+        _reclaim_counter* m_reclaimed;
+        std::atomic<long> m_refs;
+    };
+
+    template<class connection_base, class mt_policy>
+    class _signal_storage<connection_base, mt_policy, emit_snapshot> : public _signal_base<mt_policy>
+    {
+    public:
+        static_assert(!_uses_static_storage<connection_base>::value,
+            "SIGSLOT_STATIC_STORAGE only supports the locked threading modes");
+
+        typedef _connection_snapshot<connection_base> snapshot_type;
+        typedef _connection_slot<connection_base> slot_type;
+        typedef typename snapshot_type::connections_vector connections_vector;
+        typedef typename connections_vector::const_iterator const_iterator;
+
+        // Pins the current snapshot for the duration of an emit. The signal lock is only held
+        // while the reference is taken, so slots run unlocked and may connect, disconnect or
+        // re-emit this signal. Connections made during an emit are seen by the next one.
+        class emit_scope
+        {
+        public:
+            emit_scope(_signal_storage* signal)
+            {
+                {
+                    lock_block<mt_policy> lock(signal);
+                    m_snapshot = signal->m_snapshot;
+                    m_snapshot->acquire();
+                }
+
+                m_frame.m_signal = signal;
+                m_frame.m_prev = _current_emit_frame();
+                _current_emit_frame() = &m_frame;
+            }
+
+            ~emit_scope()
+            {
+                _current_emit_frame() = m_frame.m_prev;
+                snapshot_type::release(m_snapshot);
+            }
+
+            size_t size() const
+            {
+                return m_snapshot->m_connections.size();
+            }
+
+            const slot_type& operator[](size_t i) const
+            {
+                return m_snapshot->m_connections[i];
+            }
+
+        private:
+            snapshot_type* m_snapshot;
+            _emit_frame m_frame;
+        };
+
+        _signal_storage()
+            : _signal_base<mt_policy>(&try_disconnect_thunk), m_reclaimed(new _reclaim_counter)
+        {
+            m_snapshot = new snapshot_type(1, m_reclaimed);
+        }
+
+        ~_signal_storage()
+        {
+            {
+                lock_block<mt_policy> lock(this);
+                remove_connections(_receiver_match<mt_policy>(NULL));
+            }
+
+            snapshot_type::release(m_snapshot);
+            m_reclaimed->release();
+        }
+
+        // Once this returns, emits running on other threads are done with pslot, so it may be
+        // destroyed. A disconnect made from inside a slot of this signal cannot wait for its own
+        // emit, and in-flight emits on other threads may still call the slot once.
+        void disconnect(has_slots<mt_policy>* pslot = NULL)
+        {
+            unsigned long retired;
+
+            {
+                lock_block<mt_policy> lock(this);
+                retired = remove_connections(_receiver_match<mt_policy>(pslot));
+            }
+
+            if(retired != 0 && !_is_emitting(this))
+                wait_for(retired);
+        }
+
+        // Disconnects every receiver in [first, last), publishing one new snapshot for all of
+        // them, and waits for emits on other threads as disconnect does.
+        template<class iterator_type>
+        void disconnect_all_of(iterator_type first, iterator_type last)
+        {
+            _receiver_set<mt_policy> receivers(first, last);
+            unsigned long retired;
+
+            {
+                lock_block<mt_policy> lock(this);
+                retired = remove_connections(receivers);
+            }
+
+            if(retired != 0 && !_is_emitting(this))
+                wait_for(retired);
+        }
+
+        // Waits for emits on other threads as disconnect does.
+        void disconnect_id(_connection_id id)
+        {
+            unsigned long retired;
+
+            {
+                lock_block<mt_policy> lock(this);
+                retired = remove_connection(id, true);
+            }
+
+            if(retired != 0 && !_is_emitting(this))
+                wait_for(retired);
+        }
+
+        // Emits still holding the old snapshot must be waited for as in disconnect, but once
+        // the lock is released this signal may be destroyed, so wait pins the reclaim counter
+        // rather than this signal.
+        bool try_disconnect(_connection_id id, _reclaim_wait& wait)
+        {
+            if(!this->try_lock())
+                return false;
+
+            unsigned long retired = remove_connection(id, false);
+
+            if(retired != 0 && !_is_emitting(this) &&
+                m_reclaimed->m_generation.load(std::memory_order_acquire) < retired)
+            {
+                wait.add(m_reclaimed, retired);
+            }
+
+            this->unlock();
+            return true;
+        }
+
+        static bool try_disconnect_thunk(_signal_base<mt_policy>* signal, _connection_id id,
+            _reclaim_wait& wait)
+        {
+            return static_cast<_signal_storage*>(signal)->try_disconnect(id, wait);
+        }
+
+        // A no-op: every connect copies the connections into a new snapshot of exactly the
+        // right size. Present so that callers need not care which emit model is in use.
+        void reserve(size_t)
+        {
+        }
+
+        // Walks the current snapshot, without the signal lock.
+        void for_each_connection(connection_visit visit, void* context)
+        {
+            _visit_connections(this, visit, context);
+        }
+
+        // Counts the current snapshot only, not older ones that emits still hold.
+        size_t heap_bytes()
+        {
+            lock_block<mt_policy> lock(this);
+            return sizeof(snapshot_type) + sizeof(_reclaim_counter) +
+                _heap_bytes(m_snapshot->m_connections) + m_ids.heap_bytes();
+        }
+
+    protected:
+        _connection_id add_connection(const connection_base& conn, int priority)
+        {
+            lock_block<mt_policy> lock(this);
+            const connections_vector& current = m_snapshot->m_connections;
+            size_t position = m_ids.insert_position(current, priority);
+            _connection_id id = m_ids.acquire(position, priority);
+            snapshot_type* next = new snapshot_type(m_snapshot->m_generation + 1, m_reclaimed);
+            next->m_connections.reserve(current.size() + 1);
+            next->m_connections.insert(next->m_connections.end(), current.begin(),
+                current.begin() + position);
+            next->m_connections.push_back(slot_type(conn, id.m_index));
+            next->m_connections.insert(next->m_connections.end(), current.begin() + position,
+                current.end());
+            m_ids.renumber(next->m_connections, position + 1);
+            publish(next);
+            conn.notify_connect(this, id);
+            return id;
+        }
+
+        // Connects make(*it) for each element of [first, last), all at one priority, with one
+        // copy of the array and one new snapshot for the whole batch.
+        template<class iterator_type, class make_type>
+        size_t add_connections(iterator_type first, iterator_type last, make_type make,
+            int priority)
+        {
+            if(first == last)
+                return 0;
+
+            lock_block<mt_policy> lock(this);
+            const connections_vector& current = m_snapshot->m_connections;
+            size_t position = m_ids.insert_position(current, priority);
+            snapshot_type* next = new snapshot_type(m_snapshot->m_generation + 1, m_reclaimed);
+            next->m_connections.reserve(current.size() + std::distance(first, last));
+            next->m_connections.insert(next->m_connections.end(), current.begin(),
+                current.begin() + position);
+
+            for(; first != last; ++first)
+            {
+                connection_base conn = make(*first);
+                _connection_id id = m_ids.acquire(next->m_connections.size(), priority);
+                conn.notify_connect(this, id);
+                next->m_connections.push_back(slot_type(conn, id.m_index));
+            }
+
+            size_t made = next->m_connections.size() - position;
+            next->m_connections.insert(next->m_connections.end(), current.begin() + position,
+                current.end());
+            m_ids.renumber(next->m_connections, position + made);
+            publish(next);
+            return made;
+        }
+
+    private:
+        // Called with the signal lock held. Returns the generation of the snapshot that still
+        // lists the connection, or 0 if it was already gone. The id saves the search, but every
+        // change copies the array in this model, so this is still linear in the slot count.
+        unsigned long remove_connection(_connection_id id, bool notify)
+        {
+            size_t position;
+
+            if(!m_ids.find(id, position))
+                return 0;
+
+            const connections_vector& current = m_snapshot->m_connections;
+
+            if(notify)
+                current[position]->notify_disconnect(this, id);
+
+            m_ids.release(id.m_index);
+
+            unsigned long retired = m_snapshot->m_generation;
+            snapshot_type* next = new snapshot_type(retired + 1, m_reclaimed);
+            next->m_connections.reserve(current.size() - 1);
+            next->m_connections.insert(next->m_connections.end(), current.begin(),
+                current.begin() + position);
+            next->m_connections.insert(next->m_connections.end(), current.begin() + position + 1,
+                current.end());
+            m_ids.renumber(next->m_connections, position);
+            publish(next);
+            return retired;
+        }
+
+        // Called with the signal lock held. Removes every connection whose receiver match
+        // picks, and returns as remove_connection does.
+        template<class match_type>
+        unsigned long remove_connections(const match_type& match)
+        {
+            snapshot_type* current = m_snapshot;
+            connections_vector remaining;
+            const_iterator it = current->m_connections.begin();
+            const_iterator itEnd = current->m_connections.end();
+            bool found = false;
+
+            while(it != itEnd)
+            {
+                if(match((*it)->getdest()))
+                {
+                    (*it)->notify_disconnect(this, m_ids.id(it->index()));
+                    m_ids.release(it->index());
+                    found = true;
+                }
+                else
+                {
+                    remaining.push_back(*it);
+                }
+
+                ++it;
+            }
+
+            if(!found)
+                return 0;
+
+            m_ids.renumber(remaining, 0);
+
+            unsigned long retired = current->m_generation;
+            snapshot_type* next = new snapshot_type(retired + 1, m_reclaimed);
+            next->m_connections.swap(remaining);
+            publish(next);
+            return retired;
+        }
+
+        void wait_for(unsigned long retired) const
+        {
+            while(m_reclaimed->m_generation.load(std::memory_order_acquire) < retired)
+                std::this_thread::yield();
+        }
+
+        // Called with the signal lock held. Emits still using the old snapshot keep it, and
+        // through it the new one, alive until they finish.
+        void publish(snapshot_type* next)
+        {
+            snapshot_type* prev = m_snapshot;
+            next->acquire();
+            prev->m_next = next;
+            m_snapshot = next;
+            snapshot_type::release(prev);
+        }
+
+        snapshot_type* m_snapshot;
+        _reclaim_counter* m_reclaimed;
+        _connection_table m_ids;
+    };
+
+#ifndef _SIGSLOT_SINGLE_THREADED
+    // Epoch based reclamation for emit_lockfree signals. Every thread that emits owns a record
+    // in which it announces the global epoch it entered its emit in, or 0 while it is outside
+    // one. Retired memory is tagged with the epoch at which it was unlinked and freed once every
+    // announced epoch is newer, so readers only ever write to their own record.
+    class _epoch_domain
+    {
+    public:
+        struct record
+        {
+            std::atomic<unsigned long> m_epoch;
+            std::atomic<bool> m_in_use;
+            unsigned long m_depth;
+            record* m_next;
+            char m_pad[64];
+        };
+
+        _epoch_domain()
+            : m_epoch(1), m_records(NULL)
+        {
+        }
+
+        ~_epoch_domain()
+        {
+            reclaim(~0UL);
+
+            record* r = m_records.load(std::memory_order_acquire);
+
+            while(r != NULL)
+            {
+                record* next = r->m_next;
+                delete r;
+                r = next;
+            }
+        }
+
+        static _epoch_domain& instance()
+        {
+            static _epoch_domain domain;
+            return domain;
+        }
+
+        static record* local_record()
+        {
+            static thread_local thread_record local;
+            return local.m_record;
+        }
+
+        static void enter(record* r)
+        {
+            // The announcement must be ordered before the emit reads the signal's array, which
+            // is why it is a seq_cst exchange paired with a seq_cst load in emit_scope.
+            if(r->m_depth++ == 0)
+            {
+                r->m_epoch.exchange(instance().m_epoch.load(std::memory_order_relaxed),
+                    std::memory_order_seq_cst);
+            }
+        }
+
+        static void leave(record* r)
+        {
+            if(--r->m_depth == 0)
+                r->m_epoch.store(0, std::memory_order_release);
+        }
+
+        // Queues ptr for deletion and returns the epoch it was retired in. The pointer must
+        // already be unreachable for emits that start from now on.
+        unsigned long retire(void* ptr, void (*deleter)(void*))
+        {
+            retired entry;
+            entry.m_epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+            entry.m_ptr = ptr;
+            entry.m_deleter = deleter;
+
+            {
+                lock_block<multi_threaded_local> lock(&m_lock);
+                m_retired.push_back(entry);
+            }
+
+            reclaim(min_active());
+            return entry.m_epoch;
+        }
+
+        // Waits until no emit that started in or before epoch is still running. Must not be
+        // called from inside an emit of the calling thread.
+        void synchronize(unsigned long epoch)
+        {
+            while(min_active() <= epoch)
+                std::this_thread::yield();
+
+            reclaim(min_active());
+        }
+
+    private:
+        class thread_record
+        {
+        public:
+            thread_record()
+                : m_record(instance().acquire_record())
+            {
+            }
+
+            ~thread_record()
+            {
+                m_record->m_epoch.store(0, std::memory_order_release);
+                m_record->m_in_use.store(false, std::memory_order_release);
+            }
+
+            record* m_record;
+        };
+
+        struct retired
+        {
+            unsigned long m_epoch;
+            void* m_ptr;
+            void (*m_deleter)(void*);
+        };
+
+        record* acquire_record()
+        {
+            for(record* r = m_records.load(std::memory_order_acquire); r != NULL; r = r->m_next)
+            {
+                bool expected = false;
+
+                if(!r->m_in_use.load(std::memory_order_relaxed) &&
+                    r->m_in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                {
+                    return r;
+                }
+            }
+
+            record* r = new record;
+            r->m_epoch.store(0, std::memory_order_relaxed);
+            r->m_in_use.store(true, std::memory_order_relaxed);
+            r->m_depth = 0;
+            r->m_next = m_records.load(std::memory_order_relaxed);
+
+            while(!m_records.compare_exchange_weak(r->m_next, r, std::memory_order_release,
+                std::memory_order_relaxed))
+            {
+            }
+
+            return r;
+        }
+
+        unsigned long min_active() const
+        {
+            unsigned long oldest = ~0UL;
+
+            for(record* r = m_records.load(std::memory_order_acquire); r != NULL; r = r->m_next)
+            {
+                unsigned long epoch = r->m_epoch.load(std::memory_order_seq_cst);
+
+                if(epoch != 0 && epoch < oldest)
+                    oldest = epoch;
+            }
+
+            return oldest;
+        }
+
+        // Frees everything retired before the oldest epoch still announced by a reader.
+        void reclaim(unsigned long oldest)
+        {
+            std::vector<retired> ready;
+
+            {
+                lock_block<multi_threaded_local> lock(&m_lock);
+                std::vector<retired> keep;
+
+                for(size_t i = 0; i < m_retired.size(); ++i)
+                {
+                    if(m_retired[i].m_epoch < oldest)
+                        ready.push_back(m_retired[i]);
+                    else
+                        keep.push_back(m_retired[i]);
+                }
+
+                m_retired.swap(keep);
+            }
+
+            for(size_t i = 0; i < ready.size(); ++i)
+                ready[i].m_deleter(ready[i].m_ptr);
+        }
+
+        std::atomic<unsigned long> m_epoch;
+        std::atomic<record*> m_records;
+        multi_threaded_local m_lock;
+        std::vector<retired> m_retired;
+    };
+
+
+    // A signal's connections as published to lockfree emits.
+    template<class connection_base>
+    class _connection_array : public _allocated_object
+    {
+    public:
+        typedef _connection_slot<connection_base> slot_type;
+        typedef std::vector<slot_type, _allocator<slot_type> > connections_vector;
+
+        static void destroy(void* array)
+        {
+            delete static_cast<_connection_array*>(array);
+        }
+
+        connections_vector m_connections;
+    };
+
+    template<class connection_base, class mt_policy>
+    class _signal_storage<connection_base, mt_policy, emit_lockfree> : public _signal_base<mt_policy>
+    {
+    public:
+        static_assert(!_uses_static_storage<connection_base>::value,
+            "SIGSLOT_STATIC_STORAGE only supports the locked threading modes");
+
+        typedef _connection_array<connection_base> array_type;
+        typedef _connection_slot<connection_base> slot_type;
+        typedef typename array_type::connections_vector connections_vector;
+        typedef typename connections_vector::const_iterator const_iterator;
+
+        // Reads the current array inside an epoch critical section. No lock is taken, so slots
+        // may connect, disconnect or re-emit this signal. Connections made during an emit are
+        // seen by the next one.
+        class emit_scope
+        {
+        public:
+            emit_scope(_signal_storage* signal)
+                : m_record(_epoch_domain::local_record())
+            {
+                _epoch_domain::enter(m_record);
+                m_array = signal->m_array.load(std::memory_order_seq_cst);
+            }
+
+            ~emit_scope()
+            {
+                _epoch_domain::leave(m_record);
+            }
+
+            size_t size() const
+            {
+                return m_array->m_connections.size();
+            }
+
+            const slot_type& operator[](size_t i) const
+            {
+                return m_array->m_connections[i];
+            }
+
+        private:
+            _epoch_domain::record* m_record;
+            array_type* m_array;
+        };
+
+        _signal_storage()
+            : _signal_base<mt_policy>(&try_disconnect_thunk), m_array(new array_type)
+        {
+        }
+
+        ~_signal_storage()
+        {
+            {
+                lock_block<mt_policy> lock(this);
+                remove_connections(_receiver_match<mt_policy>(NULL));
+            }
+
+            delete m_array.load(std::memory_order_relaxed);
+        }
+
+        // Once this returns, emits running on other threads are done with pslot, so it may be
+        // destroyed. When called from inside an emit the wait is skipped, and emits already
+        // running on other threads may still call the slot once.
+        void disconnect(has_slots<mt_policy>* pslot = NULL)
+        {
+            unsigned long retired;
+
+            {
+                lock_block<mt_policy> lock(this);
+                retired = remove_connections(_receiver_match<mt_policy>(pslot));
+            }
+
+            if(retired != 0 && _epoch_domain::local_record()->m_depth == 0)
+                _epoch_domain::instance().synchronize(retired);
+        }
+
+        // Disconnects every receiver in [first, last), retiring one array for all of them.
+        template<class iterator_type>
+        void disconnect_all_of(iterator_type first, iterator_type last)
+        {
+            _receiver_set<mt_policy> receivers(first, last);
+            unsigned long retired;
+
+            {
+                lock_block<mt_policy> lock(this);
+                retired = remove_connections(receivers);
+            }
+
+            if(retired != 0 && _epoch_domain::local_record()->m_depth == 0)
+                _epoch_domain::instance().synchronize(retired);
+        }
+
+        void disconnect_id(_connection_id id)
+        {
+            unsigned long retired;
+
+            {
+                lock_block<mt_policy> lock(this);
+                retired = remove_connection(id, true);
+            }
+
+            if(retired != 0 && _epoch_domain::local_record()->m_depth == 0)
+                _epoch_domain::instance().synchronize(retired);
+        }
+
+        // Leaves the wait for emits still using the old array to the receiver, as with
+        // emit_snapshot. The epoch domain is shared by every signal, so it outlives this one.
+        bool try_disconnect(_connection_id id, _reclaim_wait& wait)
+        {
+            if(!this->try_lock())
+                return false;
+
+            unsigned long retired = remove_connection(id, false);
+            this->unlock();
+
+            if(retired != 0 && _epoch_domain::local_record()->m_depth == 0)
+                wait.add(&synchronize, retired);
+
+            return true;
+        }
+
+        static void synchronize(unsigned long epoch)
+        {
+            _epoch_domain::instance().synchronize(epoch);
+        }
+
+        static bool try_disconnect_thunk(_signal_base<mt_policy>* signal, _connection_id id,
+            _reclaim_wait& wait)
+        {
+            return static_cast<_signal_storage*>(signal)->try_disconnect(id, wait);
+        }
+
+        // A no-op, as with snapshot_emit: connect publishes an exactly sized array each time.
+        void reserve(size_t)
+        {
+        }
+
+        void for_each_connection(connection_visit visit, void* context)
+        {
+            _visit_connections(this, visit, context);
+        }
+
+        // As with snapshot_emit, retired arrays not yet reclaimed are not counted.
+        size_t heap_bytes()
+        {
+            lock_block<mt_policy> lock(this);
+            return sizeof(array_type) +
+                _heap_bytes(m_array.load(std::memory_order_relaxed)->m_connections) +
+                m_ids.heap_bytes();
+        }
+
+    protected:
+        _connection_id add_connection(const connection_base& conn, int priority)
+        {
+            lock_block<mt_policy> lock(this);
+            const connections_vector& current =
+                m_array.load(std::memory_order_relaxed)->m_connections;
+            size_t position = m_ids.insert_position(current, priority);
+            _connection_id id = m_ids.acquire(position, priority);
+            array_type* next = new array_type;
+            next->m_connections.reserve(current.size() + 1);
+            next->m_connections.insert(next->m_connections.end(), current.begin(),
+                current.begin() + position);
+            next->m_connections.push_back(slot_type(conn, id.m_index));
+            next->m_connections.insert(next->m_connections.end(), current.begin() + position,
+                current.end());
+            m_ids.renumber(next->m_connections, position + 1);
+            publish(next);
+            conn.notify_connect(this, id);
+            return id;
+        }
+
+        // As with snapshot_emit, one new array for the whole batch.
+        template<class iterator_type, class make_type>
+        size_t add_connections(iterator_type first, iterator_type last, make_type make,
+            int priority)
+        {
+            if(first == last)
+                return 0;
+
+            lock_block<mt_policy> lock(this);
+            const connections_vector& current =
+                m_array.load(std::memory_order_relaxed)->m_connections;
+            size_t position = m_ids.insert_position(current, priority);
+            array_type* next = new array_type;
+            next->m_connections.reserve(current.size() + std::distance(first, last));
+            next->m_connections.insert(next->m_connections.end(), current.begin(),
+                current.begin() + position);
+
+            for(; first != last; ++first)
+            {
+                connection_base conn = make(*first);
+                _connection_id id = m_ids.acquire(next->m_connections.size(), priority);
+                conn.notify_connect(this, id);
+                next->m_connections.push_back(slot_type(conn, id.m_index));
+            }
+
+            size_t made = next->m_connections.size() - position;
+            next->m_connections.insert(next->m_connections.end(), current.begin() + position,
+                current.end());
+            m_ids.renumber(next->m_connections, position + made);
+            publish(next);
+            return made;
+        }
+
+    private:
+        // Called with the signal lock held. Returns the epoch the replaced array was retired
+        // in, or 0 if the connection was already gone. As with snapshot_emit the array is
+        // copied, so this is linear in the slot count even though the id saves the search.
+        unsigned long remove_connection(_connection_id id, bool notify)
+        {
+            size_t position;
+
+            if(!m_ids.find(id, position))
+                return 0;
+
+            const connections_vector& current = m_array.load(std::memory_order_relaxed)->m_connections;
+
+            if(notify)
+                current[position]->notify_disconnect(this, id);
+
+            m_ids.release(id.m_index);
+
+            array_type* next = new array_type;
+            next->m_connections.reserve(current.size() - 1);
+            next->m_connections.insert(next->m_connections.end(), current.begin(),
+                current.begin() + position);
+            next->m_connections.insert(next->m_connections.end(), current.begin() + position + 1,
+                current.end());
+            m_ids.renumber(next->m_connections, position);
+            return publish(next);
+        }
+
+        // Called with the signal lock held. Removes every connection whose receiver match
+        // picks, and returns as remove_connection does.
+        template<class match_type>
+        unsigned long remove_connections(const match_type& match)
+        {
+            const array_type* current = m_array.load(std::memory_order_relaxed);
+            connections_vector remaining;
+            const_iterator it = current->m_connections.begin();
+            const_iterator itEnd = current->m_connections.end();
+            bool found = false;
+
+            while(it != itEnd)
+            {
+                if(match((*it)->getdest()))
+                {
+                    (*it)->notify_disconnect(this, m_ids.id(it->index()));
+                    m_ids.release(it->index());
+                    found = true;
+                }
+                else
+                {
+                    remaining.push_back(*it);
+                }
+
+                ++it;
+            }
+
+            if(!found)
+                return 0;
+
+            m_ids.renumber(remaining, 0);
+
+            array_type* next = new array_type;
+            next->m_connections.swap(remaining);
+            return publish(next);
+        }
+
+        // Called with the signal lock held.
+        unsigned long publish(array_type* next)
+        {
+            array_type* prev = m_array.exchange(next, std::memory_order_seq_cst);
+            return _epoch_domain::instance().retire(prev, &array_type::destroy);
+        }
+
+        std::atomic<array_type*> m_array;
+        _connection_table m_ids;
+    };
+#endif // _SIGSLOT_SINGLE_THREADED
+
+#ifndef _SIGSLOT_SINGLE_THREADED
+    // Worker threads for basic_signal::emit_parallel. A job is split into numbered chunks that
+    // the workers and the thread that submitted it claim one at a time from a shared counter, so
+    // an idle worker picks up whatever is left of any job in progress. The submitting thread
+    // always takes part, which also makes it safe to submit from inside a job.
+    class thread_pool
+    {
+    public:
+        // By default one worker per core besides the calling thread.
+        explicit thread_pool(size_t threads = default_size())
+            : m_stop(false)
+        {
+            for(size_t i = 0; i < threads; ++i)
+                m_workers.push_back(std::thread(&thread_pool::worker, this));
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        ~thread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+
+            m_wake.notify_all();
+
+            for(size_t i = 0; i < m_workers.size(); ++i)
+                m_workers[i].join();
+        }
+
+        size_t size() const
+        {
+            return m_workers.size();
+        }
+
+        // Calls run(context, i) for every i below count and returns once all of them have
+        // returned. Calls for different i run concurrently and in no particular order.
+        void parallel_for(size_t count, void (*run)(void*, size_t), void* context)
+        {
+            job j(count, run, context);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_jobs.push_back(&j);
+            }
+
+            m_wake.notify_all();
+            work_on(j);
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            retire(&j);
+
+            while(j.m_users != 0)
+                m_idle.wait(lock);
+        }
+
+    private:
+        struct job
+        {
+            job(size_t count, void (*run)(void*, size_t), void* context)
+                : m_run(run), m_context(context), m_count(count), m_next(0), m_users(0)
+            {
+            }
+
+            void (*m_run)(void*, size_t);
+            void* m_context;
+            size_t m_count;
+            std::atomic<size_t> m_next;
+            size_t m_users;     // workers inside the job, guarded by m_mutex
+        };
+
+        static size_t default_size()
+        {
+            unsigned cores = std::thread::hardware_concurrency();
+            return cores > 1 ? cores - 1 : 0;
+        }
+
+        static void work_on(job& j)
+        {
+            size_t i;
+
+            while((i = j.m_next.fetch_add(1, std::memory_order_relaxed)) < j.m_count)
+                j.m_run(j.m_context, i);
+        }
+
+        // Called with m_mutex held once every chunk of j has been claimed.
+        void retire(job* j)
+        {
+            for(size_t i = 0; i < m_jobs.size(); ++i)
+            {
+                if(m_jobs[i] == j)
+                {
+                    m_jobs.erase(m_jobs.begin() + i);
+                    return;
+                }
+            }
+        }
+
+        void worker()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while(true)
+            {
+                while(!m_stop && m_jobs.empty())
+                    m_wake.wait(lock);
+
+                if(m_stop)
+                    return;
+
+                job* j = m_jobs.front();
+                ++j->m_users;
+                lock.unlock();
+                work_on(*j);
+                lock.lock();
+                retire(j);
+
+                if(--j->m_users == 0)
+                    m_idle.notify_all();
+            }
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        std::vector<job*> m_jobs;
+        std::vector<std::thread> m_workers;
+        bool m_stop;
+    };
+
+    // Set up by each thread calling slots for an emit_parallel. Under the locked models the
+    // emitting thread's lock covers them all, so this only marks the thread for the asserts in
+    // _emit_lock_block and try_disconnect.
+    template<class storage_type, class model>
+    class _parallel_scope
+    {
+    public:
+        _parallel_scope(storage_type* signal)
+            : m_prev(_parallel_emit_signal())
+        {
+            _parallel_emit_signal() = signal;
+        }
+
+        ~_parallel_scope()
+        {
+            _parallel_emit_signal() = m_prev;
+        }
+
+    private:
+        const void* m_prev;
+    };
+
+    // The unlocked models give each thread an emit scope of its own, so that a slot calling
+    // back into the signal from a pool thread behaves as it would in an ordinary emit, and a
+    // disconnect does not wait for the emit it is part of.
+    template<class storage_type>
+    class _parallel_scope<storage_type, emit_snapshot>
+    {
+    public:
+        _parallel_scope(storage_type* signal)
+            : m_scope(signal)
+        {
+        }
+
+    private:
+        typename storage_type::emit_scope m_scope;
+    };
+
+    template<class storage_type>
+    class _parallel_scope<storage_type, emit_lockfree>
+        : public _parallel_scope<storage_type, emit_snapshot>
+    {
+    public:
+        _parallel_scope(storage_type* signal)
+            : _parallel_scope<storage_type, emit_snapshot>(signal)
+        {
+        }
+    };
+#endif // _SIGSLOT_SINGLE_THREADED
+
+    // Makes the connection of each receiver for connect_many.
+    template<class connection_type, class desttype, class memfun_type>
+    struct _connection_maker
+    {
+        connection_type operator()(desttype* pclass) const
+        {
+            return connection_type(pclass, m_pmemfun);
+        }
+
+        memfun_type m_pmemfun;
+    };
+
+    // A signal taking any number of arguments. sigslot::signal<...> uses the default threading
+    // policy; signal0 to signal8 below are aliases kept for existing code.
+    template<class mt_policy, class... arg_types>
+    class basic_signal : public _signal_storage<_connection_base<mt_policy, arg_types...>,
+        mt_policy>
+    {
+    public:
+        typedef _signal_storage<_connection_base<mt_policy, arg_types...>, mt_policy>
+            storage_type;
+
+        // Slots of higher priority are called first, and a slot returning bool can stop the
+        // emit by returning true. Both exact forms are here so that an overloaded slot name
+        // resolves to the one taking the signal's own arguments.
+        template<class desttype>
+        connection connect(desttype* pclass, void (desttype::*pmemfun)(arg_types...),
+            int priority = 0)
+        {
+            _connection<desttype, void (desttype::*)(arg_types...), mt_policy, arg_types...>
+                conn(pclass, pmemfun);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        template<class desttype>
+        connection connect(desttype* pclass, bool (desttype::*pmemfun)(arg_types...),
+            int priority = 0)
+        {
+            _connection<desttype, bool (desttype::*)(arg_types...), mt_policy, arg_types...>
+                conn(pclass, pmemfun);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        // Accepts slots whose parameters differ from the signal's but can be initialised from
+        // them, typically const T& for a signal of T.
+        template<class desttype, class result_type, class... slot_arg_types>
+        connection connect(desttype* pclass, result_type (desttype::*pmemfun)(slot_arg_types...),
+            int priority = 0)
+        {
+            static_assert(sizeof...(slot_arg_types) == sizeof...(arg_types),
+                "the slot must take as many arguments as the signal");
+            _connection<desttype, result_type (desttype::*)(slot_arg_types...), mt_policy,
+                arg_types...> conn(pclass, pmemfun);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        // Connects a lambda, function object or free function taking the signal's arguments. It
+        // is copied into the connection, so it must be trivially copyable and no larger than two
+        // pointers. Nothing disconnects it but the handle or the signal itself.
+        template<class functor_type>
+        typename std::enable_if<!std::is_member_function_pointer<functor_type>::value,
+            connection>::type connect(functor_type functor, int priority = 0)
+        {
+            _functor_connection<functor_type, mt_policy, arg_types...> conn(NULL, functor);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        // As above, disconnected when ptracker is destroyed. ptracker is typically a
+        // connection_tracker member of the object the function refers to.
+        template<class functor_type>
+        typename std::enable_if<!std::is_member_function_pointer<functor_type>::value,
+            connection>::type connect(has_slots<mt_policy>* ptracker, functor_type functor,
+            int priority = 0)
+        {
+            _functor_connection<functor_type, mt_policy, arg_types...> conn(ptracker, functor);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        // Connects a slot that takes a batch of calls at once. See emit_batch.
+        template<class desttype>
+        connection connect(desttype* pclass,
+            void (desttype::*pmemfun)(span<const std::tuple<arg_types...> >), int priority = 0)
+        {
+            _batch_connection<desttype, mt_policy, arg_types...> conn(pclass, pmemfun);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        // Queues every call for the thread draining queue instead of calling the slot directly;
+        // emit only copies the arguments and posts them. See event_queue. The priority orders
+        // the posting; a queued slot cannot stop the emit.
+        template<class desttype, class... slot_arg_types>
+        connection connect(desttype* pclass, void (desttype::*pmemfun)(slot_arg_types...),
+            queued_connection how, int priority = 0)
+        {
+            static_assert(sizeof...(slot_arg_types) == sizeof...(arg_types),
+                "the slot must take as many arguments as the signal");
+            static_assert(!_has_mutable_reference<arg_types...>::value,
+                "a queued call cannot hand a non-const reference back to the emitter");
+            pclass->make_token();
+            _queued_connection<desttype, void (desttype::*)(slot_arg_types...), mt_policy,
+                arg_types...> conn(pclass, pmemfun, how.m_queue);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        // Connects pmemfun of each receiver in [first, last), a forward range of pointers, at
+        // one priority, taking the signal's lock and growing its storage once for the whole
+        // range. Returns how many were connected; there are no handles, so the connections go
+        // with disconnect_all_of, disconnect(pslot) or the receivers' destruction.
+        template<class iterator_type, class desttype, class result_type, class... slot_arg_types>
+        size_t connect_many(iterator_type first, iterator_type last,
+            result_type (desttype::*pmemfun)(slot_arg_types...), int priority = 0)
+        {
+            static_assert(sizeof...(slot_arg_types) == sizeof...(arg_types),
+                "the slot must take as many arguments as the signal");
+            typedef result_type (desttype::*memfun_type)(slot_arg_types...);
+            _connection_maker<_connection<desttype, memfun_type, mt_policy, arg_types...>,
+                desttype, memfun_type> make = { pmemfun };
+            return this->add_connections(first, last, make, priority);
+        }
+
+        // Arguments are passed as param_traits selects, by const reference unless they are
+        // small, all the way to the slots. Stops early if a slot returns true.
+        void emit(typename param_traits<arg_types>::type... args)
+        {
+            _emit_trace<basic_signal> trace(this);
+            typename storage_type::emit_scope scope(this);
+            _emit_probe<mt_policy> probe(this, scope.size());
+
+            for(size_t i = 0; i < scope.size(); ++i)
+            {
+                if(!scope[i].disconnected())
+                {
+                    trace.slot_begin(scope[i]);
+                    if(scope[i]->emit(args...))
+                    {
+                        trace.slot_end(scope[i]);
+                        probe.called(scope[i], i);
+                        break;
+                    }
+
+                    trace.slot_end(scope[i]);
+                    probe.called(scope[i], i);
+                }
+            }
+        }
+
+        // Emits once per row of rows, taking the lock (or snapshot, or epoch) once for the lot.
+        // Instrumentation counts it as one emit, and each slot's calls for all rows as one.
+        // Each slot is called for every row before the next slot is called, so a slot sees the
+        // rows in order, but calls to different slots are not interleaved as separate emits
+        // would interleave them. A batch slot receives all of rows in one call.
+        void emit_batch(span<const std::tuple<arg_types...> > rows)
+        {
+            if(rows.empty())
+                return;
+
+            _emit_trace<basic_signal> trace(this);
+            typename storage_type::emit_scope scope(this);
+            _emit_probe<mt_policy> probe(this, scope.size());
+
+            for(size_t i = 0; i < scope.size(); ++i)
+            {
+                if(!scope[i].disconnected())
+                {
+                    trace.slot_begin(scope[i]);
+                    scope[i]->emit_batch(rows);
+                    trace.slot_end(scope[i]);
+                    probe.called(scope[i], i);
+                }
+            }
+        }
+
+#ifndef _SIGSLOT_SINGLE_THREADED
+        // Calls the slots on the threads of pool as well as this one, and returns once they
+        // have all returned. The slots are split into contiguous chunks, each called in
+        // connection order by a single thread; different chunks run concurrently, so the slots
+        // must be independent of each other. Under the locked models this thread holds the
+        // signal lock throughout, so the slots must not re-emit, connect to or disconnect from
+        // this signal, nor destroy a receiver connected to it: that would deadlock or race the
+        // other threads, and asserts instead. Under emit_snapshot and emit_lockfree each thread
+        // runs its chunks in an emit scope of its own, and the slots may do all of these.
+        // Instrumentation and tracing see the emit as a whole only.
+        void emit_parallel(thread_pool& pool, typename param_traits<arg_types>::type... args)
+        {
+            _emit_trace<basic_signal> trace(this);
+            typename storage_type::emit_scope scope(this);
+            _emit_probe<mt_policy> probe(this, scope.size());
+            size_t chunks = (pool.size() + 1) * 4;
+            size_t chunk_size = (scope.size() + chunks - 1) / chunks;
+
+            if(chunk_size < 1)
+                chunk_size = 1;
+
+            parallel_emit call(this, scope, chunk_size, args...);
+            pool.parallel_for((scope.size() + chunk_size - 1) / chunk_size, &parallel_emit::run,
+                &call);
+        }
+#endif
+
+        void operator()(typename param_traits<arg_types>::type... args)
+        {
+            emit(args...);
+        }
+
+    private:
+#ifndef _SIGSLOT_SINGLE_THREADED
+        typedef std::tuple<typename param_traits<arg_types>::type...> arg_tuple;
+
+        // One emit_parallel in progress: the slots it calls and the arguments to pass them.
+        struct parallel_emit
+        {
+            parallel_emit(storage_type* signal, const typename storage_type::emit_scope& scope,
+                size_t chunk_size, typename param_traits<arg_types>::type... args)
+                : m_signal(signal), m_scope(scope), m_chunk_size(chunk_size), m_args(args...)
+            {
+            }
+
+            static void run(void* context, size_t chunk)
+            {
+                const parallel_emit* call = static_cast<const parallel_emit*>(context);
+                _parallel_scope<storage_type, typename _emit_model<mt_policy>::type>
+                    scope(call->m_signal);
+                size_t end = (chunk + 1) * call->m_chunk_size;
+
+                if(end > call->m_scope.size())
+                    end = call->m_scope.size();
+
+                for(size_t i = chunk * call->m_chunk_size; i < end; ++i)
+                {
+                    if(!call->m_scope[i].disconnected())
+                        call->invoke(call->m_scope[i],
+                            typename _make_index_sequence<sizeof...(arg_types)>::type());
+                }
+            }
+
+            template<size_t... indices>
+            void invoke(const typename storage_type::slot_type& slot,
+                _index_sequence<indices...>) const
+            {
+                slot->emit(std::get<indices>(m_args)...);
+            }
+
+            storage_type* m_signal;
+            const typename storage_type::emit_scope& m_scope;
+            size_t m_chunk_size;
+            arg_tuple m_args;
+        };
+#endif
+    };
+
+    template<class... arg_types>
+    using signal = basic_signal<SIGSLOT_DEFAULT_MT_POLICY, arg_types...>;
+
+    template<class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    using signal0 = basic_signal<mt_policy>;
+
+    template<class arg1_type, class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    using signal1 = basic_signal<mt_policy, arg1_type>;
+
+    template<class arg1_type, class arg2_type, class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    using signal2 = basic_signal<mt_policy, arg1_type, arg2_type>;
+
+    template<class arg1_type, class arg2_type, class arg3_type,
+    class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    using signal3 = basic_signal<mt_policy, arg1_type, arg2_type, arg3_type>;
+
+    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
+    class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    using signal4 = basic_signal<mt_policy, arg1_type, arg2_type, arg3_type, arg4_type>;
+
+    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
+    class arg5_type, class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    using signal5 = basic_signal<mt_policy, arg1_type, arg2_type, arg3_type, arg4_type,
+        arg5_type>;
+
+    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
+    class arg5_type, class arg6_type, class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    using signal6 = basic_signal<mt_policy, arg1_type, arg2_type, arg3_type, arg4_type,
+        arg5_type, arg6_type>;
+
+    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
+    class arg5_type, class arg6_type, class arg7_type, class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    using signal7 = basic_signal<mt_policy, arg1_type, arg2_type, arg3_type, arg4_type,
+        arg5_type, arg6_type, arg7_type>;
+
+    template<class arg1_type, class arg2_type, class arg3_type, class arg4_type,
+    class arg5_type, class arg6_type, class arg7_type, class arg8_type,
+    class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    using signal8 = basic_signal<mt_policy, arg1_type, arg2_type, arg3_type, arg4_type,
+        arg5_type, arg6_type, arg7_type, arg8_type>;
+
+    // A signal whose slots each subscribe to one key, for signals that would otherwise have every
+    // slot compare an argument against the one value it cares about. emit(key, args...) calls
+    // only the slots connected under key, through a flat hash index, so it costs one lookup and
+    // the matching slots however many other keys are connected. The slots take the key as their
+    // first argument, so a slot of signal<key_type, arg_types...> connects unchanged.
+    //
+    // Each key has a basic_signal of its own, which does the connection bookkeeping and receiver
+    // tracking and gives the key the signal's threading model. The index is read without a
+    // lock, by emit and by the calls that visit every key, so a keyed emit is as concurrent as
+    // the key's signal under the policy: shared under multi_threaded_rw, lock free under
+    // multi_threaded_lockfree. Only adding a key takes the index's own lock, and no signal's
+    // lock is taken while it is held, so slots may connect further keys while being called. A
+    // key stays indexed until the keyed signal is destroyed, even once its slots are gone, so
+    // the set of keys should be bounded. key_type is hashed with std::hash.
+    template<class mt_policy, class key_type, class... arg_types>
+    class basic_keyed_signal : public _receiver_policy<mt_policy>::type
+    {
+    public:
+        typedef basic_signal<mt_policy, key_type, arg_types...> signal_type;
+
+        basic_keyed_signal()
+            : m_table(NULL), m_size(0)
+        {
+        }
+
+        basic_keyed_signal(const basic_keyed_signal&) = delete;
+        basic_keyed_signal& operator=(const basic_keyed_signal&) = delete;
+
+        ~basic_keyed_signal()
+        {
+            table* current = m_table.load(std::memory_order_relaxed);
+
+            for(size_t i = 0; current != NULL && i <= current->m_mask; ++i)
+                delete current->m_buckets[i].m_entry.load(std::memory_order_relaxed);
+
+            while(current != NULL)
+            {
+                table* older = current->m_older;
+                delete current;
+                current = older;
+            }
+        }
+
+        template<class desttype>
+        connection connect(const key_type& key, desttype* pclass,
+            void (desttype::*pmemfun)(key_type, arg_types...), int priority = 0)
+        {
+            return signal_for(key).connect(pclass, pmemfun, priority);
+        }
+
+        template<class desttype>
+        connection connect(const key_type& key, desttype* pclass,
+            bool (desttype::*pmemfun)(key_type, arg_types...), int priority = 0)
+        {
+            return signal_for(key).connect(pclass, pmemfun, priority);
+        }
+
+        template<class desttype, class result_type, class... slot_arg_types>
+        connection connect(const key_type& key, desttype* pclass,
+            result_type (desttype::*pmemfun)(slot_arg_types...), int priority = 0)
+        {
+            return signal_for(key).connect(pclass, pmemfun, priority);
+        }
+
+        template<class functor_type>
+        typename std::enable_if<!std::is_member_function_pointer<functor_type>::value,
+            connection>::type connect(const key_type& key, functor_type functor, int priority = 0)
+        {
+            return signal_for(key).connect(functor, priority);
+        }
+
+        template<class functor_type>
+        typename std::enable_if<!std::is_member_function_pointer<functor_type>::value,
+            connection>::type connect(const key_type& key, has_slots<mt_policy>* ptracker,
+            functor_type functor, int priority = 0)
+        {
+            return signal_for(key).connect(ptracker, functor, priority);
+        }
+
+        template<class desttype, class... slot_arg_types>
+        connection connect(const key_type& key, desttype* pclass,
+            void (desttype::*pmemfun)(slot_arg_types...), queued_connection how,
+            int priority = 0)
+        {
+            return signal_for(key).connect(pclass, pmemfun, how, priority);
+        }
+
+        // Disconnects pslot under every key. This visits each key, where the receiver's own
+        // teardown goes straight to its connections.
+        void disconnect(has_slots<mt_policy>* pslot = NULL)
+        {
+            const table* current = m_table.load(std::memory_order_acquire);
+
+            for(size_t i = 0; current != NULL && i <= current->m_mask; ++i)
+            {
+                entry* found = current->m_buckets[i].m_entry.load(std::memory_order_acquire);
+
+                if(found != NULL)
+                    found->m_signal.disconnect(pslot);
+            }
+        }
+
+        void disconnect_key(const key_type& key)
+        {
+            entry* found = find(key);
+
+            if(found != NULL)
+                found->m_signal.disconnect();
+        }
+
+        // Makes room in the index for n keys, so that connecting up to that many does not rehash.
+        void reserve(size_t n)
+        {
+            lock_block<index_policy> lock(this);
+            const table* current = m_table.load(std::memory_order_relaxed);
+
+            if(current == NULL || n * 2 > current->m_mask + 1)
+                rehash(n * 2);
+        }
+
+        // Visits the connections of every key in turn.
+        void for_each_connection(connection_visit visit, void* context)
+        {
+            const table* current = m_table.load(std::memory_order_acquire);
+
+            for(size_t i = 0; current != NULL && i <= current->m_mask; ++i)
+            {
+                entry* found = current->m_buckets[i].m_entry.load(std::memory_order_acquire);
+
+                if(found != NULL)
+                    found->m_signal.for_each_connection(visit, context);
+            }
+        }
+
+        // The index, including the tables it has outgrown, and each key's entry with its
+        // signal's connections. Keys whose slots are all gone still count, as they stay indexed.
+        size_t heap_bytes()
+        {
+            const table* current = m_table.load(std::memory_order_acquire);
+            size_t bytes = 0;
+
+            for(const table* t = current; t != NULL; t = t->m_older)
+                bytes += sizeof(table) + (t->m_mask + 1) * sizeof(bucket);
+
+            for(size_t i = 0; current != NULL && i <= current->m_mask; ++i)
+            {
+                entry* found = current->m_buckets[i].m_entry.load(std::memory_order_acquire);
+
+                if(found != NULL)
+                    bytes += sizeof(entry) + found->m_signal.heap_bytes();
+            }
+
+            return bytes;
+        }
+
+        void emit(typename param_traits<key_type>::type key,
+            typename param_traits<arg_types>::type... args)
+        {
+            entry* found = find(key);
+
+            if(found != NULL)
+                found->m_signal.emit(key, args...);
+        }
+
+        void operator()(typename param_traits<key_type>::type key,
+            typename param_traits<arg_types>::type... args)
+        {
+            emit(key, args...);
+        }
+
+    private:
+        typedef typename _receiver_policy<mt_policy>::type index_policy;
+
+        struct entry : public _allocated_object
+        {
+            entry(const key_type& key, size_t hash)
+                : m_key(key), m_hash(hash)
+            {
+            }
+
+            key_type m_key;
+            size_t m_hash;
+            signal_type m_signal;
+        };
+
+        // Buckets keep each entry's hash next to its pointer, so that a probe only follows the
+        // pointer of an entry that is likely to match. A bucket is filled once, hash first, and
+        // its entry published last, so a reader that sees the entry also sees the hash.
+        struct bucket
+        {
+            bucket()
+                : m_hash(0), m_entry(NULL)
+            {
+            }
+
+            size_t m_hash;
+            std::atomic<entry*> m_entry;
+        };
+
+        // Linear probing, with the table at most half full. Entries are never removed, so a
+        // table only ever gains entries until it is outgrown. It is then replaced by one twice
+        // the size, and kept, linked from its successor, until the keyed signal is destroyed,
+        // as emits may still be probing it; together the outgrown tables take less memory
+        // than the current one.
+        struct table : public _allocated_object
+        {
+            table(size_t size, table* older)
+                : m_mask(size - 1), m_older(older), m_buckets(size)
+            {
+            }
+
+            size_t m_mask;
+            table* m_older;
+            std::vector<bucket, _allocator<bucket> > m_buckets;
+        };
+
+        // std::hash is the identity for integers in common implementations, and keys such as
+        // ids are often spaced evenly, so the bits are mixed before the table size masks them.
+        static size_t hash_of(const key_type& key)
+        {
+            size_t h = std::hash<key_type>()(key);
+            h ^= h >> (sizeof(size_t) * 4);
+            h *= static_cast<size_t>(0x9E3779B97F4A7C15ULL);
+            return h ^ (h >> (sizeof(size_t) * 4));
+        }
+
+        // The bucket key's entry is in, or the empty bucket where it would go. A table always
+        // has an empty bucket, so this ends.
+        static size_t probe(const table* t, const key_type& key, size_t hash)
+        {
+            size_t i = hash & t->m_mask;
+
+            while(true)
+            {
+                entry* found = t->m_buckets[i].m_entry.load(std::memory_order_acquire);
+
+                if(found == NULL || (t->m_buckets[i].m_hash == hash && found->m_key == key))
+                    return i;
+
+                i = (i + 1) & t->m_mask;
+            }
+        }
+
+        // Takes no lock, so keyed emits cost what the key's own signal does under the policy. A
+        // key connected while this runs may be missed, as if connected just after.
+        entry* find(const key_type& key) const
+        {
+            const table* current = m_table.load(std::memory_order_acquire);
+
+            if(current == NULL)
+                return NULL;
+
+            size_t i = probe(current, key, hash_of(key));
+            return current->m_buckets[i].m_entry.load(std::memory_order_acquire);
+        }
+
+        // Entries stay where they were allocated, so a signal found under the lock may be
+        // emitted after it is released.
+        signal_type& signal_for(const key_type& key)
+        {
+            size_t hash = hash_of(key);
+            lock_block<index_policy> lock(this);
+            table* current = m_table.load(std::memory_order_relaxed);
+
+            if(current == NULL || (m_size + 1) * 2 > current->m_mask + 1)
+                current = rehash(current == NULL ? 16 : (current->m_mask + 1) * 2);
+
+            bucket& slot = current->m_buckets[probe(current, key, hash)];
+            entry* found = slot.m_entry.load(std::memory_order_relaxed);
+
+            if(found == NULL)
+            {
+                found = new entry(key, hash);
+                slot.m_hash = hash;
+                slot.m_entry.store(found, std::memory_order_release);
+                ++m_size;
+            }
+
+            return found->m_signal;
+        }
+
+        // Called with the index lock held. The new table is filled before it is published.
+        table* rehash(size_t capacity)
+        {
+            size_t size = 16;
+
+            while(size < capacity)
+                size *= 2;
+
+            table* old = m_table.load(std::memory_order_relaxed);
+            table* next = new table(size, old);
+
+            for(size_t i = 0; old != NULL && i <= old->m_mask; ++i)
+            {
+                entry* moved = old->m_buckets[i].m_entry.load(std::memory_order_relaxed);
+
+                if(moved != NULL)
+                {
+                    bucket& slot = next->m_buckets[probe(next, moved->m_key, moved->m_hash)];
+                    slot.m_hash = moved->m_hash;
+                    slot.m_entry.store(moved, std::memory_order_relaxed);
+                }
+            }
+
+            m_table.store(next, std::memory_order_release);
+            return next;
+        }
+
+        std::atomic<table*> m_table;
+        size_t m_size;
+    };
+
+    template<class key_type, class... arg_types>
+    using keyed_signal = basic_keyed_signal<SIGSLOT_DEFAULT_MT_POLICY, key_type, arg_types...>;
+
+    // Combiners reduce the results of the slots of one basic_result_signal emit. A combiner is
+    // default constructed for each emit, or passed to combine(), and is handed each result in
+    // call order through operator(), which returns true to call no further slots. result()
+    // gives what emit returns. Everything happens on the emitting thread's stack, so the
+    // combiners below never allocate, bar combine_vector.
+    template<class T>
+    class combine_last
+    {
+    public:
+        typedef T result_type;
+
+        combine_last()
+            : m_value()
+        {
+        }
+
+        bool operator()(const T& value)
+        {
+            m_value = value;
+            return false;
+        }
+
+        // A value initialised T if no slot was called.
+        T result()
+        {
+            return m_value;
+        }
+
+    private:
+        T m_value;
+    };
+
+    template<class T>
+    class combine_sum
+    {
+    public:
+        typedef T result_type;
+
+        combine_sum()
+            : m_total()
+        {
+        }
+
+        bool operator()(const T& value)
+        {
+            m_total += value;
+            return false;
+        }
+
+        T result()
+        {
+            return m_total;
+        }
+
+    private:
+        T m_total;
+    };
+
+    // The smallest result by operator<, or a value initialised T if no slot was called.
+    template<class T>
+    class combine_min
+    {
+    public:
+        typedef T result_type;
+
+        combine_min()
+            : m_value(), m_any(false)
+        {
+        }
+
+        bool operator()(const T& value)
+        {
+            if(!m_any || value < m_value)
+                m_value = value;
+
+            m_any = true;
+            return false;
+        }
+
+        T result()
+        {
+            return m_value;
+        }
+
+    private:
+        T m_value;
+        bool m_any;
+    };
+
+    // The largest result by operator<, or a value initialised T if no slot was called.
+    template<class T>
+    class combine_max
+    {
+    public:
+        typedef T result_type;
+
+        combine_max()
+            : m_value(), m_any(false)
+        {
+        }
+
+        bool operator()(const T& value)
+        {
+            if(!m_any || m_value < value)
+                m_value = value;
+
+            m_any = true;
+            return false;
+        }
+
+        T result()
+        {
+            return m_value;
+        }
+
+    private:
+        T m_value;
+        bool m_any;
+    };
+
+    // Every result, in call order.
+    template<class T>
+    class combine_vector
+    {
+    public:
+        typedef std::vector<T> result_type;
+
+        bool operator()(const T& value)
+        {
+            m_values.push_back(value);
+            return false;
+        }
+
+        result_type result()
+        {
+            return std::move(m_values);
+        }
+
+    private:
+        result_type m_values;
+    };
+
+    template<class signature>
+    struct _signature_result;
+
+    template<class result_type, class... arg_types>
+    struct _signature_result<result_type (arg_types...)>
+    {
+        typedef result_type type;
+    };
+
+    // A signal whose slots return a value, declared by the signature it calls them with, such as
+    // basic_result_signal<mt_policy, int (double)>. emit runs the results through a combiner and
+    // returns what it makes of them: the last result by default. Connections, priorities and
+    // the threading models are those of basic_signal; queued and batch slots, which have no
+    // result to give, are not supported, nor is emit_parallel.
+    template<class mt_policy, class signature,
+    class combiner_type = combine_last<typename _signature_result<signature>::type> >
+    class basic_result_signal;
+
+    template<class mt_policy, class result_type, class... arg_types, class combiner_type>
+    class basic_result_signal<mt_policy, result_type (arg_types...), combiner_type>
+        : public _signal_storage<_result_connection_base<mt_policy, result_type, arg_types...>,
+        mt_policy>
+    {
+    public:
+        typedef _signal_storage<_result_connection_base<mt_policy, result_type, arg_types...>,
+            mt_policy> storage_type;
+
+        static_assert(!std::is_void<result_type>::value,
+            "a signal whose slots return nothing is a basic_signal");
+
+        template<class desttype>
+        connection connect(desttype* pclass, result_type (desttype::*pmemfun)(arg_types...),
+            int priority = 0)
+        {
+            _result_connection<desttype, result_type (desttype::*)(arg_types...), mt_policy,
+                result_type, arg_types...> conn(pclass, pmemfun);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        // Accepts slots whose parameters and result differ from the signal's but convert.
+        template<class desttype, class slot_result_type, class... slot_arg_types>
+        connection connect(desttype* pclass,
+            slot_result_type (desttype::*pmemfun)(slot_arg_types...), int priority = 0)
+        {
+            static_assert(sizeof...(slot_arg_types) == sizeof...(arg_types),
+                "the slot must take as many arguments as the signal");
+            _result_connection<desttype, slot_result_type (desttype::*)(slot_arg_types...),
+                mt_policy, result_type, arg_types...> conn(pclass, pmemfun);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        // Function objects as for basic_signal::connect.
+        template<class functor_type>
+        typename std::enable_if<!std::is_member_function_pointer<functor_type>::value,
+            connection>::type connect(functor_type functor, int priority = 0)
+        {
+            _result_functor_connection<functor_type, mt_policy, result_type, arg_types...>
+                conn(NULL, functor);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        template<class functor_type>
+        typename std::enable_if<!std::is_member_function_pointer<functor_type>::value,
+            connection>::type connect(has_slots<mt_policy>* ptracker, functor_type functor,
+            int priority = 0)
+        {
+            _result_functor_connection<functor_type, mt_policy, result_type, arg_types...>
+                conn(ptracker, functor);
+            return connection(this, this->add_connection(conn, priority));
+        }
+
+        typename combiner_type::result_type emit(typename param_traits<arg_types>::type... args)
+        {
+            combiner_type combiner;
+            combine(combiner, args...);
+            return combiner.result();
+        }
+
+        typename combiner_type::result_type operator()(
+            typename param_traits<arg_types>::type... args)
+        {
+            return emit(args...);
+        }
+
+        // Emits into a combiner of the caller's, of any type, so that one signal can be reduced
+        // differently at different call sites, or into a combiner that needs arguments.
+        template<class other_combiner_type>
+        void combine(other_combiner_type& combiner, typename param_traits<arg_types>::type... args)
+        {
+            _emit_trace<basic_result_signal> trace(this);
+            typename storage_type::emit_scope scope(this);
+            _emit_probe<mt_policy> probe(this, scope.size());
+
+            for(size_t i = 0; i < scope.size(); ++i)
+            {
+                if(!scope[i].disconnected())
+                {
+                    trace.slot_begin(scope[i]);
+                    bool stop = combiner(scope[i]->emit(args...));
+                    trace.slot_end(scope[i]);
+                    probe.called(scope[i], i);
+
+                    if(stop)
+                        break;
+                }
+            }
+        }
+    };
+
+    template<class signature,
+    class combiner_type = combine_last<typename _signature_result<signature>::type> >
+    using result_signal = basic_result_signal<SIGSLOT_DEFAULT_MT_POLICY, signature,
+        combiner_type>;
+
+    // A signal for values of which only the latest matters, such as a refresh request or a
+    // changed setting. emit only stores a copy of its arguments, replacing any not yet delivered,
+    // and flush() calls the slots once with the latest of them, if there was an emit since the
+    // last delivery. Slots are thus called once per flush however often the signal fires. The
+    // argument types, as decayed, must be default constructible and copy assignable.
+    //
+    // deliver_through(queue, window) has the thread owning queue flush instead: an emit posts
+    // one flush message if none is waiting, and that message delivers at most once per window.
+    // Arriving early, it is deferred on the queue to the end of the window since the last
+    // delivery, and delivered by the first process() after that; the event loop should arm a
+    // timer on queue.next_deadline() so that the last value is not held back until the next
+    // post. As with queued connections, the signal should be destroyed on the queue's thread; a
+    // message outliving it is dropped.
+    // Connecting, disconnecting and the threading model are those of basic_signal.
+    template<class mt_policy, class... arg_types>
+    class basic_coalescing_signal : private basic_signal<mt_policy, arg_types...>
+    {
+    public:
+        typedef basic_signal<mt_policy, arg_types...> signal_type;
+        typedef std::chrono::steady_clock::duration duration;
+
+        using signal_type::connect;
+        using signal_type::disconnect;
+        using signal_type::reserve;
+        using signal_type::connect_many;
+        using signal_type::disconnect_all_of;
+        using signal_type::for_each_connection;
+        using signal_type::heap_bytes;
+
+        basic_coalescing_signal()
+            : m_dirty(false), m_posted(false), m_queue(NULL), m_window(duration::zero()),
+            m_token(NULL)
+        {
+        }
+
+        basic_coalescing_signal(const basic_coalescing_signal&) = delete;
+        basic_coalescing_signal& operator=(const basic_coalescing_signal&) = delete;
+
+        ~basic_coalescing_signal()
+        {
+            if(m_token != NULL)
+            {
+                m_token->expire();
+                m_token->release();
+            }
+        }
+
+        // Call before the first emit, from the thread that will emit.
+        void deliver_through(event_queue& queue, duration window = duration::zero())
+        {
+            m_queue = &queue;
+            m_window = window;
+
+            if(m_token == NULL)
+                m_token = new _receiver_token;
+        }
+
+        void emit(typename param_traits<arg_types>::type... args)
+        {
+            bool post;
+
+            {
+                lock_block<latest_policy> lock(&m_latest_lock);
+                m_latest = value_tuple(args...);
+                m_dirty = true;
+                post = m_queue != NULL && !m_posted;
+                m_posted = m_posted || post;
+            }
+
+            if(post)
+                m_queue->post(new flush_message(this));
+        }
+
+        void operator()(typename param_traits<arg_types>::type... args)
+        {
+            emit(args...);
+        }
+
+        // Whether an emit is waiting to be delivered.
+        bool pending() const
+        {
+            lock_block<latest_policy> lock(&m_latest_lock);
+            return m_dirty;
+        }
+
+        // Calls the slots with the latest arguments, and returns false without calling them if
+        // nothing was emitted since the last delivery. Flushes must not race each other.
+        bool flush()
+        {
+            value_tuple latest;
+
+            {
+                lock_block<latest_policy> lock(&m_latest_lock);
+
+                if(!m_dirty)
+                    return false;
+
+                latest = std::move(m_latest);
+                m_dirty = false;
+                m_delivered = std::chrono::steady_clock::now();
+            }
+
+            deliver(latest, typename _make_index_sequence<sizeof...(arg_types)>::type());
+            return true;
+        }
+
+    private:
+        typedef typename _receiver_policy<mt_policy>::type latest_policy;
+        typedef std::tuple<typename std::decay<arg_types>::type...> value_tuple;
+
+        // The flush that deliver_through posts. Holds a reference to the signal's token, so
+        // that a message left in the queue by a destroyed signal is dropped.
+        class flush_message : public _deferred_message
+        {
+        public:
+            flush_message(basic_coalescing_signal* signal)
+                : m_signal(signal), m_token(signal->m_token)
+            {
+                m_run = &run;
+                m_token->add_ref();
+            }
+
+        private:
+            static void run(_queued_message* msg, bool deliver)
+            {
+                flush_message* message = static_cast<flush_message*>(msg);
+
+                if(deliver && message->m_token->alive() && message->m_signal->posted_flush(message))
+                    return;
+
+                message->m_token->release();
+                delete message;
+            }
+
+            basic_coalescing_signal* m_signal;
+            _receiver_token* m_token;
+        };
+
+        // Flushes, or defers message to the end of the window and returns true, keeping it the
+        // one pending flush.
+        bool posted_flush(flush_message* message)
+        {
+            std::chrono::steady_clock::time_point due;
+            bool early;
+
+            {
+                lock_block<latest_policy> lock(&m_latest_lock);
+                due = m_delivered + m_window;
+                early = std::chrono::steady_clock::now() < due;
+                m_posted = early;
+            }
+
+            if(!early)
+            {
+                flush();
+                return false;
+            }
+
+            m_queue->defer(message, due);
+            return true;
+        }
+
+        template<size_t... indices>
+        void deliver(const value_tuple& latest, _index_sequence<indices...>)
+        {
+            signal_type::emit(std::get<indices>(latest)...);
+        }
+
+        mutable latest_policy m_latest_lock;
+        value_tuple m_latest;
+        bool m_dirty;
+        bool m_posted;
+        event_queue* m_queue;
+        duration m_window;
+        std::chrono::steady_clock::time_point m_delivered;
+        _receiver_token* m_token;
+    };
+
+    template<class... arg_types>
+    using coalescing_signal = basic_coalescing_signal<SIGSLOT_DEFAULT_MT_POLICY, arg_types...>;
+
+#ifdef _SIGSLOT_HAS_POSIX_THREADS
+    // A named POSIX shared memory segment mapped into this process. create() replaces any
+    // segment of that name and removes the name again on destruction; open() maps one that
+    // another process created. Both return false, leaving the object unmapped, on failure.
+    class _shm_segment
+    {
+    public:
+        _shm_segment()
+            : m_base(NULL), m_size(0), m_owner(false)
+        {
+        }
+
+        _shm_segment(const _shm_segment&) = delete;
+        _shm_segment& operator=(const _shm_segment&) = delete;
+
+        ~_shm_segment()
+        {
+            close();
+        }
+
+        bool create(const char* name, size_t size)
+        {
+            close();
+            shm_unlink(name);
+            int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+
+            if(fd < 0)
+                return false;
+
+            if(ftruncate(fd, static_cast<off_t>(size)) != 0 || !map(fd, size))
+            {
+                ::close(fd);
+                shm_unlink(name);
+                return false;
+            }
+
+            ::close(fd);
+            m_owner = true;
+            m_name.assign(name, name + strlen(name) + 1);
+            return true;
+        }
+
+        bool open(const char* name)
+        {
+            close();
+            int fd = shm_open(name, O_RDWR, 0);
+            struct stat info;
+
+            if(fd < 0)
+                return false;
+
+            bool mapped = fstat(fd, &info) == 0 && map(fd, static_cast<size_t>(info.st_size));
+            ::close(fd);
+            return mapped;
+        }
+
+        void close()
+        {
+            if(m_base != NULL)
+                munmap(m_base, m_size);
+
+            if(m_owner)
+                shm_unlink(&m_name[0]);
+
+            m_base = NULL;
+            m_size = 0;
+            m_owner = false;
+        }
+
+        void* base() const
+        {
+            return m_base;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+    private:
+        bool map(int fd, size_t size)
+        {
+            void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+            if(base == MAP_FAILED)
+                return false;
+
+            m_base = base;
+            m_size = size;
+            return true;
+        }
+
+        void* m_base;
+        size_t m_size;
+        bool m_owner;
+        std::vector<char> m_name;
+    };
+
+    // A bounded ring of fixed size messages laid out in a shared memory segment, which any
+    // number of processes may write and one may read. Each cell carries a sequence number
+    // telling writers when it is free and the reader when it is full, so neither side makes a
+    // system call or takes a lock; writers only contend on the compare-and-swap that claims a
+    // cell. The atomics must be lock-free to work across processes.
+    class _shm_ring
+    {
+    public:
+        typedef unsigned long long sequence_type;
+
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+            "shared memory rings need address-free atomics");
+
+        _shm_ring()
+            : m_header(NULL), m_cells(NULL), m_stride(0)
+        {
+        }
+
+        // Lays out a ring of at least capacity messages in a new segment.
+        bool create(const char* name, size_t capacity, size_t message_size)
+        {
+            size_t cells = 1;
+
+            while(cells < capacity)
+                cells *= 2;
+
+            size_t stride = cell_stride(message_size);
+
+            if(!m_segment.create(name, sizeof(header) + cells * stride))
+                return false;
+
+            header* ring = new (m_segment.base()) header;
+            ring->m_message_size = static_cast<unsigned>(message_size);
+            ring->m_capacity = cells;
+            ring->m_enqueue.store(0, std::memory_order_relaxed);
+            ring->m_dequeue.store(0, std::memory_order_relaxed);
+            attach(ring, stride);
+
+            for(size_t i = 0; i < cells; ++i)
+                new (cell_at(i)) std::atomic<sequence_type>(i);
+
+            ring->m_ready.store(ready, std::memory_order_release);
+            return true;
+        }
+
+        // Fails if the segment is missing, not yet initialised or holds messages of another size.
+        bool open(const char* name, size_t message_size)
+        {
+            if(!m_segment.open(name) || m_segment.size() < sizeof(header))
+                return false;
+
+            header* ring = static_cast<header*>(m_segment.base());
+
+            if(ring->m_ready.load(std::memory_order_acquire) != ready ||
+                ring->m_message_size != message_size ||
+                m_segment.size() < sizeof(header) + ring->m_capacity * cell_stride(message_size))
+            {
+                m_segment.close();
+                return false;
+            }
+
+            attach(ring, cell_stride(message_size));
+            return true;
+        }
+
+        bool is_open() const
+        {
+            return m_header != NULL;
+        }
+
+        // Copies a message into the ring, or returns false if the ring is full.
+        bool push(const void* message)
+        {
+            sequence_type mask = m_header->m_capacity - 1;
+            sequence_type position = m_header->m_enqueue.load(std::memory_order_relaxed);
+            std::atomic<sequence_type>* cell;
+
+            for(;;)
+            {
+                cell = cell_at(position & mask);
+                sequence_type sequence = cell->load(std::memory_order_acquire);
+
+                if(sequence == position)
+                {
+                    if(m_header->m_enqueue.compare_exchange_weak(position, position + 1,
+                        std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if(static_cast<long long>(sequence - position) < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_header->m_enqueue.load(std::memory_order_relaxed);
+                }
+            }
+
+            memcpy(payload(cell), message, m_header->m_message_size);
+            cell->store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // The oldest message, or NULL if the ring is empty. Only the reader may call this, and
+        // the message stays valid until it calls pop().
+        const void* front() const
+        {
+            sequence_type position = m_header->m_dequeue.load(std::memory_order_relaxed);
+            std::atomic<sequence_type>* cell = cell_at(position & (m_header->m_capacity - 1));
+
+            if(cell->load(std::memory_order_acquire) != position + 1)
+                return NULL;
+
+            return payload(cell);
+        }
+
+        void pop()
+        {
+            sequence_type position = m_header->m_dequeue.load(std::memory_order_relaxed);
+            std::atomic<sequence_type>* cell = cell_at(position & (m_header->m_capacity - 1));
+            cell->store(position + m_header->m_capacity, std::memory_order_release);
+            m_header->m_dequeue.store(position + 1, std::memory_order_relaxed);
+        }
+
+    private:
+        static const unsigned ready = 0x51675107;
+
+        // The write and read positions sit on cache lines of their own, away from the cells.
+        struct header
+        {
+            std::atomic<unsigned> m_ready;
+            unsigned m_message_size;
+            sequence_type m_capacity;
+            alignas(64) std::atomic<sequence_type> m_enqueue;
+            alignas(64) std::atomic<sequence_type> m_dequeue;
+        };
+
+        static size_t cell_stride(size_t message_size)
+        {
+            size_t align = alignof(std::atomic<sequence_type>);
+            return sizeof(std::atomic<sequence_type>) + (message_size + align - 1) / align * align;
+        }
+
+        void attach(header* ring, size_t stride)
+        {
+            m_header = ring;
+            m_cells = reinterpret_cast<unsigned char*>(ring + 1);
+            m_stride = stride;
+        }
+
+        std::atomic<sequence_type>* cell_at(size_t index) const
+        {
+            return reinterpret_cast<std::atomic<sequence_type>*>(m_cells + index * m_stride);
+        }
+
+        static unsigned char* payload(std::atomic<sequence_type>* cell)
+        {
+            return reinterpret_cast<unsigned char*>(cell + 1);
+        }
+
+        _shm_segment m_segment;
+        header* m_header;
+        unsigned char* m_cells;
+        size_t m_stride;
+    };
+
+    // Where each argument of a bridged signal sits in a ring message. The arguments are stored
+    // one after another, each at its own alignment, and copied in and out with memcpy.
+    template<class... value_types>
+    class _shm_message_layout
+    {
+    public:
+        _shm_message_layout()
+        {
+            static const size_t sizes[] = { sizeof(value_types)..., 0 };
+            static const size_t aligns[] = { alignof(value_types)..., 1 };
+            size_t offset = 0;
+
+            for(size_t i = 0; i < sizeof...(value_types); ++i)
+            {
+                offset = (offset + aligns[i] - 1) / aligns[i] * aligns[i];
+                m_offsets[i] = offset;
+                offset += sizes[i];
+            }
+
+            m_offsets[sizeof...(value_types)] = offset;
+        }
+
+        size_t offset(size_t i) const
+        {
+            return m_offsets[i];
+        }
+
+        size_t size() const
+        {
+            return m_offsets[sizeof...(value_types)];
+        }
+
+    private:
+        size_t m_offsets[sizeof...(value_types) + 1];
+    };
+
+    template<class value_type>
+    inline value_type _shm_load(const unsigned char* bytes)
+    {
+        value_type value;
+        memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    // Whether the arguments of a bridged signal can be copied as bytes, and an upper bound on
+    // the size of a message holding them, padding included.
+    template<class... value_types>
+    struct _shm_values
+    {
+        static const bool trivially_copyable = true;
+        static const size_t max_size = 0;
+    };
+
+    template<class value_type, class... value_types>
+    struct _shm_values<value_type, value_types...>
+    {
+        static const bool trivially_copyable = std::is_trivially_copyable<value_type>::value &&
+            _shm_values<value_types...>::trivially_copyable;
+        static const size_t max_size = sizeof(value_type) + alignof(value_type) +
+            _shm_values<value_types...>::max_size;
+    };
+
+    // The sending end of a signal bridged to other processes. attach() connects it, as a
+    // receiver, to a local signal of the same threading policy, and every emit of that signal is
+    // copied into the ring for the process holding the basic_shm_bridge_reader, or counted in
+    // dropped() if the ring is full. post() sends directly. The arguments, as decayed, must be
+    // trivially copyable, and must not hold pointers the other process cannot follow. Any
+    // number of writers, in any number of processes, may share one ring.
+    template<class mt_policy, class... arg_types>
+    class basic_shm_bridge_writer : public has_slots<mt_policy>
+    {
+    public:
+        static_assert(_shm_values<typename std::decay<arg_types>::type...>::trivially_copyable,
+            "only trivially copyable arguments can cross a process boundary");
+
+        basic_shm_bridge_writer()
+            : m_dropped(0)
+        {
+        }
+
+        bool create(const char* name, size_t capacity)
+        {
+            return m_ring.create(name, capacity, m_layout.size());
+        }
+
+        bool open(const char* name)
+        {
+            return m_ring.open(name, m_layout.size());
+        }
+
+        connection attach(basic_signal<mt_policy, arg_types...>& signal)
+        {
+            return signal.connect(this, &basic_shm_bridge_writer::forward);
+        }
+
+        // Returns false if the ring is full. Only call once create() or open() has succeeded.
+        bool post(typename param_traits<arg_types>::type... args)
+        {
+            unsigned char message[
+                _shm_values<typename std::decay<arg_types>::type...>::max_size + 1];
+            store(message, 0, args...);
+            return m_ring.push(message);
+        }
+
+        void forward(typename param_traits<arg_types>::type... args)
+        {
+            if(!post(args...))
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        unsigned long long dropped() const
+        {
+            return m_dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        void store(unsigned char*, size_t)
+        {
+        }
+
+        template<class value_type, class... rest_types>
+        void store(unsigned char* message, size_t i, const value_type& value,
+            const rest_types&... rest)
+        {
+            memcpy(message + m_layout.offset(i), &value, sizeof(value));
+            store(message, i + 1, rest...);
+        }
+
+        _shm_message_layout<typename std::decay<arg_types>::type...> m_layout;
+        _shm_ring m_ring;
+        std::atomic<unsigned long long> m_dropped;
+    };
+
+    // The receiving end: a signal of its own, which poll() emits once for each message waiting
+    // in the ring, so local receivers connect to it as to any other signal. Only one thread in
+    // one process may poll a ring. Polling an empty ring reads one cache line and makes no
+    // system call; how often to poll, or how to wake the reader, is the caller's choice.
+    template<class mt_policy, class... arg_types>
+    class basic_shm_bridge_reader : public basic_signal<mt_policy, arg_types...>
+    {
+    public:
+        static_assert(_shm_values<typename std::decay<arg_types>::type...>::trivially_copyable,
+            "only trivially copyable arguments can cross a process boundary");
+
+        bool create(const char* name, size_t capacity)
+        {
+            return m_ring.create(name, capacity, m_layout.size());
+        }
+
+        bool open(const char* name)
+        {
+            return m_ring.open(name, m_layout.size());
+        }
+
+        // Emits up to max_messages messages, and returns how many it emitted.
+        size_t poll(size_t max_messages = ~size_t(0))
+        {
+            size_t count = 0;
+
+            while(count < max_messages)
+            {
+                const void* message = m_ring.front();
+
+                if(message == NULL)
+                    break;
+
+                deliver(static_cast<const unsigned char*>(message),
+                    typename _make_index_sequence<sizeof...(arg_types)>::type());
+                m_ring.pop();
+                ++count;
+            }
+
+            return count;
+        }
+
+    private:
+        typedef std::tuple<typename std::decay<arg_types>::type...> value_tuple;
+
+        template<size_t... indices>
+        void deliver(const unsigned char* message, _index_sequence<indices...>)
+        {
+            (void)message;
+            this->emit(_shm_load<typename std::tuple_element<indices, value_tuple>::type>(
+                message + m_layout.offset(indices))...);
+        }
+
+        _shm_message_layout<typename std::decay<arg_types>::type...> m_layout;
+        _shm_ring m_ring;
+    };
+
+    template<class... arg_types>
+    using shm_bridge_writer = basic_shm_bridge_writer<SIGSLOT_DEFAULT_MT_POLICY, arg_types...>;
+
+    template<class... arg_types>
+    using shm_bridge_reader = basic_shm_bridge_reader<SIGSLOT_DEFAULT_MT_POLICY, arg_types...>;
+#endif // _SIGSLOT_HAS_POSIX_THREADS
+
+    template<class memfun_type>
+    struct _memfun_class;
+
+    template<class dest_type, class result_type, class... arg_types>
+    struct _memfun_class<result_type (dest_type::*)(arg_types...)>
+    {
+        typedef dest_type type;
+    };
+
+    // One slot of a basic_static_signal: a member function fixed at compile time, such as
+    // static_slot<void (Light::*)(), &Light::ToggleState>.
+    template<class memfun_type, memfun_type memfun>
+    struct static_slot
+    {
+        typedef typename _memfun_class<memfun_type>::type dest_type;
+
+        template<class... call_types>
+        static bool call(dest_type* pobject, const call_types&... args)
+        {
+            return _slot_call<typename _memfun_result<memfun_type>::type>::member(pobject, memfun,
+                args...);
+        }
+    };
+
+    // Wiring that is fixed when the program is built: each slot is a static_slot naming its
+    // member function in the type, bound to an object when the signal is constructed. emit is
+    // a sequence of direct calls the compiler can inline, with no connection storage, lock or
+    // indirect call, and costs what the calls written out by hand would. Slots returning bool
+    // stop the emit by returning true, as with basic_signal. Nothing tracks the objects: they
+    // must outlive the signal, or at least its last emit.
+    template<class... slot_types>
+    class basic_static_signal
+    {
+    public:
+        explicit basic_static_signal(typename slot_types::dest_type*... pobjects)
+            : m_objects(pobjects...)
+        {
+        }
+
+        template<class... call_types>
+        void emit(const call_types&... args) const
+        {
+            call<0>(args...);
+        }
+
+        template<class... call_types>
+        void operator()(const call_types&... args) const
+        {
+            call<0>(args...);
+        }
+
+    private:
+        typedef std::tuple<slot_types...> slot_tuple;
+
+        template<size_t i, class... call_types>
+        typename std::enable_if<i == sizeof...(slot_types)>::type call(const call_types&...) const
+        {
+        }
+
+        template<size_t i, class... call_types>
+        typename std::enable_if<(i < sizeof...(slot_types))>::type call(
+            const call_types&... args) const
+        {
+            if(!std::tuple_element<i, slot_tuple>::type::call(std::get<i>(m_objects), args...))
+                call<i + 1>(args...);
+        }
+
+        std::tuple<typename slot_types::dest_type*...> m_objects;
+    };
+
+#if __cplusplus >= 201703L
+    // The same with the member functions listed directly: static_signal<&Light::TurnOn,
+    // &Light::TurnOff> sig(&lp1, &lp2).
+    template<auto... memfuns>
+    using static_signal = basic_static_signal<static_slot<decltype(memfuns), memfuns>...>;
+#endif
+
+    // A set of small trivially copyable values for has_slots. Up to inline_size elements live
+    // inside the object, in no particular order; beyond that they move to a sorted array from
+    // SIGSLOT_ALLOCATOR. Most receivers have a handful of connections and never touch the heap.
+    template<class T, size_t inline_size>
+    class _small_set
+    {
+    public:
+        typedef const T* const_iterator;
+
+        _small_set()
+            : m_size(0), m_capacity(inline_size)
+        {
+        }
+
+        _small_set(const _small_set& other)
+            : m_size(0), m_capacity(inline_size)
+        {
+            assign(other);
+        }
+
+        _small_set& operator=(const _small_set& other)
+        {
+            if(this != &other)
+            {
+                clear();
+                assign(other);
+            }
+
+            return *this;
+        }
+
+        ~_small_set()
+        {
+            clear();
+        }
+
+        const_iterator begin() const
+        {
+            return data();
+        }
+
+        const_iterator end() const
+        {
+            return data() + m_size;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        // Always finds room; the result is for the interface shared with _fixed_set.
+        bool insert(T value)
+        {
+            if(!spilled())
+            {
+                for(size_t i = 0; i < m_size; ++i)
+                {
+                    if(m_storage.m_inline[i] == value)
+                        return true;
+                }
+
+                if(m_size < inline_size)
+                {
+                    m_storage.m_inline[m_size++] = value;
+                    return true;
+                }
+
+                T* heap = allocator_type().allocate(inline_size * 2);
+                memcpy(heap, m_storage.m_inline, m_size * sizeof(T));
+                std::sort(heap, heap + m_size);
+                m_storage.m_heap = heap;
+                m_capacity = inline_size * 2;
+            }
+
+            T* pos = std::lower_bound(m_storage.m_heap, m_storage.m_heap + m_size, value);
+
+            if(pos != m_storage.m_heap + m_size && *pos == value)
+                return true;
+
+            if(m_size == m_capacity)
+            {
+                size_t offset = pos - m_storage.m_heap;
+                T* heap = allocator_type().allocate(m_capacity * 2);
+                memcpy(heap, m_storage.m_heap, m_size * sizeof(T));
+                allocator_type().deallocate(m_storage.m_heap, m_capacity);
+                m_storage.m_heap = heap;
+                m_capacity *= 2;
+                pos = heap + offset;
+            }
+
+            memmove(pos + 1, pos, (m_storage.m_heap + m_size - pos) * sizeof(T));
+            *pos = value;
+            ++m_size;
+            return true;
+        }
+
+        void erase(T value)
+        {
+            if(!spilled())
+            {
+                for(size_t i = 0; i < m_size; ++i)
+                {
+                    if(m_storage.m_inline[i] == value)
+                    {
+                        m_storage.m_inline[i] = m_storage.m_inline[--m_size];
+                        return;
+                    }
+                }
+
+                return;
+            }
+
+            T* last = m_storage.m_heap + m_size;
+            T* pos = std::lower_bound(m_storage.m_heap, last, value);
+
+            if(pos == last || *pos != value)
+                return;
+
+            memmove(pos, pos + 1, (last - pos - 1) * sizeof(T));
+            --m_size;
+
+            // Move back inline as soon as everything fits, which frees the heap array.
+            if(m_size <= inline_size)
+            {
+                T* heap = m_storage.m_heap;
+                memcpy(m_storage.m_inline, heap, m_size * sizeof(T));
+                allocator_type().deallocate(heap, m_capacity);
+                m_capacity = inline_size;
+            }
+        }
+
+        // Makes room for n elements, so that inserting up to that many does not reallocate.
+        void reserve(size_t n)
+        {
+            if(n <= m_capacity)
+                return;
+
+            T* heap = allocator_type().allocate(n);
+            memcpy(heap, data(), m_size * sizeof(T));
+
+            if(spilled())
+                allocator_type().deallocate(m_storage.m_heap, m_capacity);
+            else
+                std::sort(heap, heap + m_size);
+
+            m_storage.m_heap = heap;
+            m_capacity = n;
+        }
+
+        size_t heap_bytes() const
+        {
+            return spilled() ? m_capacity * sizeof(T) : 0;
+        }
+
+        void clear()
+        {
+            if(spilled())
+                allocator_type().deallocate(m_storage.m_heap, m_capacity);
+
+            m_size = 0;
+            m_capacity = inline_size;
+        }
+
+    private:
+        typedef _allocator<T> allocator_type;
+
+        static_assert(std::is_trivially_copyable<T>::value,
+            "_small_set moves its elements with memcpy");
+
+        bool spilled() const
+        {
+            return m_capacity > inline_size;
+        }
+
+        T* data()
+        {
+            return spilled() ? m_storage.m_heap : m_storage.m_inline;
+        }
+
+        const T* data() const
+        {
+            return spilled() ? m_storage.m_heap : m_storage.m_inline;
+        }
+
+        void assign(const _small_set& other)
+        {
+            if(other.spilled())
+            {
+                m_storage.m_heap = allocator_type().allocate(other.m_capacity);
+                m_capacity = other.m_capacity;
+            }
+
+            memcpy(data(), other.data(), other.m_size * sizeof(T));
+            m_size = other.m_size;
+        }
+
+        size_t m_size;
+        size_t m_capacity;
+
+        union
+        {
+            T m_inline[inline_size];
+            T* m_heap;
+        } m_storage;
+    };
+
+    // The sender set of has_slots under SIGSLOT_STATIC_STORAGE: up to capacity elements inside
+    // the object, in no particular order, and never more.
+    template<class T, size_t capacity>
+    class _fixed_set
+    {
+    public:
+        typedef const T* const_iterator;
+
+        _fixed_set()
+            : m_size(0)
+        {
+        }
+
+        const_iterator begin() const
+        {
+            return m_values;
+        }
+
+        const_iterator end() const
+        {
+            return m_values + m_size;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        // Returns false if value is not in the set and there is no room for it.
+        bool insert(T value)
+        {
+            for(size_t i = 0; i < m_size; ++i)
+            {
+                if(m_values[i] == value)
+                    return true;
+            }
+
+            if(m_size == capacity)
+                return false;
+
+            m_values[m_size++] = value;
+            return true;
+        }
+
+        void erase(T value)
+        {
+            for(size_t i = 0; i < m_size; ++i)
+            {
+                if(m_values[i] == value)
+                {
+                    m_values[i] = m_values[--m_size];
+                    return;
+                }
+            }
+        }
+
+        void clear()
+        {
+            m_size = 0;
+        }
+
+        void reserve(size_t)
+        {
+        }
+
+        size_t heap_bytes() const
+        {
+            return 0;
+        }
+
+    private:
+        size_t m_size;
+        T m_values[capacity];
+    };
+
+    template<class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    class has_slots : public _receiver_policy<mt_policy>::type
+    {
+    private:
+        typedef typename _receiver_policy<mt_policy>::type lock_policy;
+
+        // One per connection made to this receiver, so that teardown can hand each signal the
+        // id of its connection instead of having the signal search for this receiver.
+        struct link
+        {
+            _signal_base<mt_policy>* m_sender;
+            _connection_id m_id;
+
+            bool operator==(const link& other) const
+            {
+                return m_sender == other.m_sender && m_id == other.m_id;
+            }
+
+            bool operator!=(const link& other) const
+            {
+                return !(*this == other);
+            }
+
+            bool operator<(const link& other) const
+            {
+                return m_sender < other.m_sender ||
+                    (m_sender == other.m_sender && m_id < other.m_id);
+            }
+        };
+
+#ifdef SIGSLOT_STATIC_STORAGE
+        typedef _fixed_set<link, SIGSLOT_MAX_SENDERS> link_set;
+#else
+        // Four links, 64 bytes, inside the receiver, so that one with up to four connections
+        // never allocates.
+        typedef _small_set<link, 4> link_set;
+#endif
+    public:
+        has_slots()
+            : m_token(NULL)
+        {
+        }
+
+        // The connections belong to the receiver they were made to, so a copy starts with none,
+        // and with no queued connections of its own.
+        has_slots(const has_slots& other)
+            : lock_policy(other), m_token(NULL)
+        {
+        }
+
+        has_slots& operator=(const has_slots&)
+        {
+            return *this;
+        }
+
+        // Returns false if this receiver has no room for another connection.
+        bool signal_connect(_signal_base<mt_policy>* sender, _connection_id id)
+        {
+            link connected = { sender, id };
+            lock_block<lock_policy> lock(this);
+            return m_links.insert(connected);
+        }
+
+        void signal_disconnect(_signal_base<mt_policy>* sender, _connection_id id)
+        {
+            link disconnected = { sender, id };
+            lock_block<lock_policy> lock(this);
+            m_links.erase(disconnected);
+        }
+
+        virtual ~has_slots()
+        {
+            disconnect();
+
+            if(m_token != NULL)
+            {
+                m_token->expire();
+                m_token->release();
+            }
+        }
+
+        // Created by the first queued connection to this receiver.
+        void make_token()
+        {
+            lock_block<lock_policy> lock(this);
+
+            if(m_token == NULL)
+                m_token = new _receiver_token;
+        }
+
+        _receiver_token* token() const
+        {
+            return m_token;
+        }
+
+        // Makes room for n connections, so that a receiver about to be wired to many signals
+        // grows its sender set once.
+        void reserve(size_t n)
+        {
+            lock_block<lock_policy> lock(this);
+            m_links.reserve(n);
+        }
+
+        // Reports each signal connected to this receiver once per connection, with the slot
+        // type left NULL. Runs under the receiver's lock, so visit must not connect or
+        // disconnect this receiver. Every disconnect, whichever end makes it, removes the
+        // connection here as well, so anything still listed once its signal is gone is a leak.
+        void for_each_connection(connection_visit visit, void* context)
+        {
+            lock_block<lock_policy> lock(this);
+
+            for(typename link_set::const_iterator it = m_links.begin(); it != m_links.end(); ++it)
+            {
+                connection_info info = { it->m_sender, this, NULL };
+                visit(context, info);
+            }
+        }
+
+        // The heap memory behind the sender set and the queued connection token, on top of
+        // the receiver's own size.
+        size_t heap_bytes()
+        {
+            lock_block<lock_policy> lock(this);
+            return m_links.heap_bytes() + (m_token != NULL ? sizeof(_receiver_token) : 0);
+        }
+
+        // Signals lock their receivers while holding their own lock, never the other way
+        // round. This runs the other way, so it only ever tries each signal's lock, and on
+        // failure lets go of its own to let that signal finish. Emits on other threads still
+        // calling the removed connections are waited for once, after the lock is released,
+        // since their slots may need it.
+        void disconnect()
+        {
+            _reclaim_wait wait;
+
+            {
+                lock_block<lock_policy> lock(this);
+
+                while(!m_links.empty())
+                {
+                    link last = *(m_links.end() - 1);
+
+                    if(last.m_sender->try_disconnect(last.m_id, wait))
+                    {
+                        m_links.erase(last);
+                    }
+                    else
+                    {
+                        _unlock_traced(static_cast<lock_policy*>(this));
+                        std::this_thread::yield();
+                        _lock_traced(static_cast<lock_policy*>(this));
+                    }
+                }
+            }
+
+            wait.wait();
+        }
+
+    private:
+        link_set m_links;
+        _receiver_token* m_token;
+    };
+
+    // Tracks lambdas for an object that does not derive from has_slots: as a member passed to
+    // signal.connect(&tracker, fn), it disconnects them when the object is destroyed.
+    template<class mt_policy = SIGSLOT_DEFAULT_MT_POLICY>
+    class connection_tracker : public has_slots<mt_policy>
+    {
+    };
+}; // namespace sigslot
+
+#endif // SIGSLOT_H__
+